@@ -9,7 +9,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-
 void LookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, 
     float sliderPosProportional, float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider)
 {
@@ -17,48 +16,62 @@ void LookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, i
 
     auto bounds = Rectangle<float>(x, y, width, height);
 
-    auto enabled = slider.isEnabled();
+    drawRotarySliderBody(g, bounds, slider.isEnabled());
+
+    if(auto* rswl = dynamic_cast<RotarySliderWithLabels*>(&slider))
+    {
+        drawRotarySliderPointer(g, bounds, sliderPosProportional, rotaryStartAngle, rotaryEndAngle, *rswl);
+    }
+}
+
+void LookAndFeel::drawRotarySliderBody(juce::Graphics& g, juce::Rectangle<float> bounds, bool enabled)
+{
+    using namespace juce;
 
     g.setColour(enabled ? Colour(97u, 18u, 167u) : Colours::darkgrey);
     g.fillEllipse(bounds);
 
     g.setColour(enabled ? Colour(255u, 154u, 1u) : Colours::grey);
     g.drawEllipse(bounds, 1.f);
+}
 
-    if(auto* rswl = dynamic_cast<RotarySliderWithLabels*>(&slider))
-    {
-        auto center = bounds.getCentre();
+void LookAndFeel::drawRotarySliderPointer(juce::Graphics& g, juce::Rectangle<float> bounds, float sliderPosProportional,
+    float rotaryStartAngle, float rotaryEndAngle, RotarySliderWithLabels& rswl)
+{
+    using namespace juce;
 
-        Path p;
+    auto enabled = rswl.isEnabled();
+    auto center = bounds.getCentre();
 
-        Rectangle<float> r;
-        r.setLeft(center.getX() - 2);
-        r.setRight(center.getX() + 2);
-        r.setTop(bounds.getY());
-        r.setBottom(center.getY() - rswl->getTextHeight() * 1.5);
+    Path p;
 
-    	p.addRoundedRectangle(r, 2.f);
+    Rectangle<float> r;
+    r.setLeft(center.getX() - 2);
+    r.setRight(center.getX() + 2);
+    r.setTop(bounds.getY());
+    r.setBottom(center.getY() - rswl.getTextHeight() * 1.5);
 
-	    jassert(rotaryStartAngle < rotaryEndAngle);
+    p.addRoundedRectangle(r, 2.f);
 
-	    auto sliderAngleRadians = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
+    jassert(rotaryStartAngle < rotaryEndAngle);
 
-	    p.applyTransform(AffineTransform().rotated(sliderAngleRadians, center.getX(), center.getY()));
-	    g.fillPath(p);
+    auto sliderAngleRadians = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
 
-        g.setFont(rswl->getTextHeight());
-        auto text = rswl->getDisplayString();
-        auto textWidth = g.getCurrentFont().getStringWidth(text);
+    g.setColour(enabled ? Colour(255u, 154u, 1u) : Colours::grey);
+    g.fillPath(p, AffineTransform::rotation(sliderAngleRadians, center.getX(), center.getY()));
 
-        r.setSize(textWidth + 4, rswl->getTextHeight() + 2);
-        r.setCentre(bounds.getCentre());
+    g.setFont(rswl.getTextHeight());
+    auto text = rswl.getDisplayString();
+    auto textWidth = g.getCurrentFont().getStringWidth(text);
 
-        g.setColour(enabled ? Colours::black : Colours::darkgrey);
-        g.fillRect(r);
+    r.setSize(textWidth + 4, rswl.getTextHeight() + 2);
+    r.setCentre(bounds.getCentre());
 
-        g.setColour(enabled ? Colours::white : Colours::lightgrey);
-        g.drawFittedText(text, r.toNearestInt(), juce::Justification::centred, 1);
-    }
+    g.setColour(enabled ? Colours::black : Colours::darkgrey);
+    g.fillRect(r);
+
+    g.setColour(enabled ? Colours::white : Colours::lightgrey);
+    g.drawFittedText(text, r.toNearestInt(), juce::Justification::centred, 1);
 }
 
 void LookAndFeel::drawToggleButton(juce::Graphics& g, juce::ToggleButton& toggleButton, 
@@ -110,9 +123,6 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
 {
     using namespace juce;
 
-    auto startAngle = degreesToRadians(180.f + 45.f);
-    auto endAngle = degreesToRadians(180.f - 45.f) + MathConstants<float>::twoPi;
-
     auto range = getRange();
 
     auto sliderBounds = getSliderBounds();
@@ -122,12 +132,45 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
     //g.setColour(Colours::yellow);
     //g.drawRect(sliderBounds);
 
+    // only the pointer and the value move, everything else comes from the cached layer
+    updateStaticLayer(Component::getApproximateScaleFactorForComponent(this));
+    g.drawImage(staticLayer, getLocalBounds().toFloat());
 
-    getLookAndFeel().drawRotarySlider(g, 
-        sliderBounds.getX(), sliderBounds.getY(), sliderBounds.getWidth(), sliderBounds.getHeight(),
-        jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0), 
+    lnf.drawRotarySliderPointer(g, sliderBounds.toFloat(),
+        jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0),
         startAngle, endAngle, *this);
+}
 
+void RotarySliderWithLabels::updateStaticLayer(float scale)
+{
+    using namespace juce;
+
+    const auto enabled = isEnabled();
+
+    if (staticLayer.isValid() && staticLayerBounds == getLocalBounds() && staticLayerScale == scale
+        && staticLayerEnabled == enabled)
+    {
+        return;
+    }
+
+    staticLayerBounds = getLocalBounds();
+    staticLayerScale = scale;
+    staticLayerEnabled = enabled;
+
+    staticLayer = Image(Image::PixelFormat::ARGB, jmax(1, roundToInt(getWidth() * scale)), jmax(1, roundToInt(getHeight() * scale)), true);
+
+    Graphics g(staticLayer);
+    g.addTransform(AffineTransform::scale(scale));
+
+    lnf.drawRotarySliderBody(g, getSliderBounds().toFloat(), enabled);
+    drawLabels(g);
+}
+
+void RotarySliderWithLabels::drawLabels(juce::Graphics& g)
+{
+    using namespace juce;
+
+    auto sliderBounds = getSliderBounds();
     auto center = sliderBounds.toFloat().getCentre();
     auto radius = sliderBounds.getWidth() * 0.5f;
 
@@ -155,6 +198,52 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
     }
 }
 
+#if YATBEQ_BENCHMARK_KNOB_RENDERING
+// one repaint of this knob into an offscreen software image, drawn from scratch the way paint() did before
+// the layer cache, and drawn over the cached layer
+void RotarySliderWithLabels::benchmarkRendering()
+{
+    using namespace juce;
+
+    constexpr int numFrames = 500;
+
+    auto sliderBounds = getSliderBounds();
+    auto range = getRange();
+    auto sliderPos = float(jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0));
+
+    for (auto scale : { 1.f, 2.f })
+    {
+        Image target(Image::ARGB, jmax(1, roundToInt(getWidth() * scale)), jmax(1, roundToInt(getHeight() * scale)), true,
+            SoftwareImageType());
+
+        const auto uncachedMs = averageMilliseconds(numFrames, [&]
+        {
+            Graphics g(target);
+            g.addTransform(AffineTransform::scale(scale));
+            lnf.drawRotarySlider(g, sliderBounds.getX(), sliderBounds.getY(), sliderBounds.getWidth(), sliderBounds.getHeight(),
+                sliderPos, startAngle, endAngle, *this);
+            drawLabels(g);
+        });
+
+        updateStaticLayer(scale);
+
+        const auto cachedMs = averageMilliseconds(numFrames, [&]
+        {
+            Graphics g(target);
+            g.addTransform(AffineTransform::scale(scale));
+            g.drawImage(staticLayer, getLocalBounds().toFloat());
+            lnf.drawRotarySliderPointer(g, sliderBounds.toFloat(), sliderPos, startAngle, endAngle, *this);
+        });
+
+        Logger::writeToLog(param->getName(32) + String::formatted(" knob at %.0fx, %dx%d: uncached %.4f ms, cached %.4f ms",
+            scale, target.getWidth(), target.getHeight(), uncachedMs, cachedMs));
+    }
+
+    // the next paint() renders the layer for the real display scale again
+    staticLayerScale = 0;
+}
+#endif
+
 juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
 {
     auto bounds = getLocalBounds();
@@ -214,8 +303,7 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 //==============================================================================
 ResponseCurveComponent::ResponseCurveComponent(YATBEQAudioProcessor& p) :
     audioProcessor(p),
-leftPathProducer(audioProcessor.leftChannelFifo),
-rightPathProducer(audioProcessor.rightChannelFifo)
+pathProducer(audioProcessor)
     //leftChannelFifo(&audioProcessor.leftChannelFifo)//,
     //rightChannelFifo(&audiProcessor.rightChannelFifo);
 {
@@ -225,12 +313,20 @@ rightPathProducer(audioProcessor.rightChannelFifo)
         param->addListener(this);
     }
 
+    audioProcessor.addAnalyzerSubscriber();
+
+    updateResponseCurve();
 
-    updateChain();
+    analyzerThread.setAnalysisArea(getAnalysisArea().toFloat(), audioProcessor.getSampleRate(),
+        juce::Component::getApproximateScaleFactorForComponent(this));
+    analyzerThread.startThread();
     startTimerHz(60);
 }
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+    analyzerThread.stopThread(1000);
+    audioProcessor.removeAnalyzerSubscriber();
+
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
@@ -245,214 +341,802 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll(Colours::black);
 
+    // three layers: the static grid, the spectrum, and the response curve rasterised in updateResponseCurve().
+    // the timer only invalidates the analysis area for a new spectrum, so most repaints are clipped to it
     g.drawImage(background, getLocalBounds().toFloat());
 
     auto responseArea = getAnalysisArea();// getLocalBounds();
 
-    auto w = responseArea.getWidth();
+    if (shouldShowFFTAnalysis)
+    {
+        if (pathProducer.getRenderer() == Analyzer_PathRenderer)
+        {
+            // drawn with the translation rather than translating a copy of each path
+            const auto toResponseArea = AffineTransform::translation(float(responseArea.getX()), float(responseArea.getY()));
 
-    auto& lowCut = monoChain.get<ChainPositions::LowCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
-    auto& highCut = monoChain.get<ChainPositions::HighCut>();
+            g.setColour(Colours::blue);
+            g.strokePath(pathProducer.getPath(0), PathStrokeType(1.f), toResponseArea);
+            g.setColour(Colours::skyblue);
+            g.strokePath(pathProducer.getPath(1), PathStrokeType(1.f), toResponseArea);
+        }
+        else if (pathProducer.getRenderer() == Analyzer_SpectrogramRenderer)
+        {
+            pathProducer.drawSpectrogram(g, responseArea.toFloat());
+        }
+        else
+        {
+            // already rasterised at the display scale on the analyzer thread, this is a plain blit
+            g.drawImage(pathProducer.getSpectrumImage(), responseArea.toFloat());
+        }
+    }
+
+    g.drawImage(responseCurveLayer, getLocalBounds().toFloat());
+}
+
+void ResponseCurveComponent::renderResponseCurveLayer()
+{
+    using namespace juce;
+
+    // rendered at the display scale so the curve stays as sharp as a stroked path
+    const auto scale = Component::getApproximateScaleFactorForComponent(this);
+    responseCurveLayerScale = scale;
+    responseCurveLayer = Image(Image::PixelFormat::ARGB, jmax(1, roundToInt(getWidth() * scale)), jmax(1, roundToInt(getHeight() * scale)), true);
+
+    Graphics g(responseCurveLayer);
+    g.addTransform(AffineTransform::scale(scale));
+
+    g.setColour(Colours::orange);
+    g.drawRoundedRectangle(getAnalysisArea().toFloat(), 4.f, 1.f);
+    //g.setColour(Colours::red);
+    //g.drawRoundedRectangle(getRenderedArea().toFloat(), 4.f, 1.f);
+    //g.setColour(Colours::green);
+    //g.drawRoundedRectangle(getLocalBounds().toFloat(), 4.f, 1.f);
+
+    g.setColour(Colours::white);
+    g.strokePath(responseCurve, PathStrokeType(2.f));
+}
+
+void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+{
+    parametersChanged.set(true);
+}
+
+void PathProducer::updateAnalysisSettings()
+{
+    using Window = juce::dsp::WindowingFunction<float>;
+
+    // in "Analyzer Window" choice order
+    static constexpr Window::WindowingMethod windowTypes[] =
+    {
+        Window::blackmanHarris, Window::hann, Window::hamming, Window::blackman, Window::flatTop, Window::rectangular
+    };
+
+    const auto newFFTSizeIndex = static_cast<int>(analyzerFFTSize->load());
+    const auto newWindowIndex = static_cast<int>(analyzerWindow->load());
+
+    if (newFFTSizeIndex != fftSizeIndex)
+    {
+        fftSizeIndex = newFFTSizeIndex;
+        windowIndex = newWindowIndex;
+
+        fftDataGenerator.changeOrder(static_cast<FFTOrder>(FFTOrder::order2048 + fftSizeIndex));
+        fftDataGenerator.changeWindow(windowTypes[windowIndex]);
+
+        analysisBuffer.setSize(2, fftDataGenerator.getFFTSize());
+        restartAnalysisBuffer();
+    }
+    else if (newWindowIndex != windowIndex)
+    {
+        windowIndex = newWindowIndex;
+        fftDataGenerator.changeWindow(windowTypes[windowIndex]);
+    }
 
-    auto sampleRate = audioProcessor.getSampleRate();
+    // in "Analyzer Averaging" and "Analyzer Smoothing" choice order
+    static constexpr float averagingCoefficients[] = { 1.f, 0.5f, 0.2f };
+    static constexpr int octaveFractions[] = { 0, 3, 6, 12 };
 
-    std::vector<double> mags;
-    mags.resize(w);
+    fftDataGenerator.setDisplayProcessing(averagingCoefficients[static_cast<int>(analyzerAveraging->load())],
+        analyzerPeakHold->load() > 0.5f,
+        octaveFractions[static_cast<int>(analyzerSmoothing->load())]);
 
-    for (int i = 0; i < w; ++i)
+    const auto decimation = leftChannelFifo->getDecimation();
+    if (decimation != analysedDecimation)
     {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+        analysedDecimation = decimation;
+
+        // every sample of the old rate was written before the left tap switched, the right tap is in step
+        // with the left, so dropping the same count from both drops all of them and keeps the pair aligned
+        const auto numQueued = juce::jmin(leftChannelFifo->getNumSamplesAvailable(),
+            rightChannelFifo->getNumSamplesAvailable());
 
-        if (!monoChain.isBypassed<ChainPositions::Peak>())
+        for (auto* fifo : { leftChannelFifo, rightChannelFifo })
         {
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+            fifo->read(numQueued, [](std::span<const float>, std::span<const float>) {});
         }
 
-        if (!monoChain.isBypassed<ChainPositions::LowCut>())
+        restartAnalysisBuffer();
+        fftDataGenerator.resetDisplayProcessing();
+    }
+}
+
+void PathProducer::restartAnalysisBuffer()
+{
+    analysisBuffer.clear();
+    writePosition = 0;
+    samplesSinceLastFrame = 0;
+}
+
+void PathProducer::readIntoAnalysisBuffer(int numSamples)
+{
+    const auto ringSize = analysisBuffer.getNumSamples();
+
+    // after a long stall only the newest ringSize samples can end up in the ring
+    if (numSamples > ringSize)
+    {
+        const auto numToSkip = numSamples - ringSize;
+        for (auto* fifo : { leftChannelFifo, rightChannelFifo })
         {
-            if (!lowCut.isBypassed<0>())
-            {
-                mag *= lowCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowCut.isBypassed<1>())
+            fifo->read(numToSkip, [](std::span<const float>, std::span<const float>) {});
+        }
+
+        writePosition = (writePosition + numToSkip) % ringSize;
+        numSamples = ringSize;
+    }
+
+    auto writeToRing = [this, ringSize](int channel, int position, std::span<const float> source)
+    {
+        // at most two copies, up to the end of the ring and then from the start
+        const auto numToEnd = juce::jmin(int(source.size()), ringSize - position);
+        juce::FloatVectorOperations::copy(analysisBuffer.getWritePointer(channel, position), source.data(), numToEnd);
+        juce::FloatVectorOperations::copy(analysisBuffer.getWritePointer(channel, 0), source.data() + numToEnd,
+            int(source.size()) - numToEnd);
+    };
+
+    auto readChannel = [&](SingleChannelSampleFifo& fifo, int channel)
+    {
+        fifo.read(numSamples, [&](std::span<const float> first, std::span<const float> second)
+        {
+            writeToRing(channel, writePosition, first);
+            writeToRing(channel, (writePosition + int(first.size())) % ringSize, second);
+        });
+    };
+
+    readChannel(*leftChannelFifo, 0);
+    readChannel(*rightChannelFifo, 1);
+
+    writePosition = (writePosition + numSamples) % ringSize;
+}
+
+void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate, float scale)
+{
+    updateAnalysisSettings();
+
+    // both taps are written together, so they always hold the same number of samples
+    const auto numAvailable = juce::jmin(leftChannelFifo->getNumSamplesAvailable(),
+        rightChannelFifo->getNumSamplesAvailable());
+
+    // "Analyzer Overlap": 50% or 75%
+    const auto fftSize = fftDataGenerator.getFFTSize();
+    const auto hopSize = analyzerOverlap->load() > 0.5f ? fftSize / 4 : fftSize / 2;
+
+    // when more than one hop came in since the last pass (the GUI or this thread fell behind) only the newest
+    // frame on the hop grid is transformed, so there is never more than one FFT per display frame
+    const auto numFramesDue = (samplesSinceLastFrame + numAvailable) / hopSize;
+
+    if (numFramesDue > 0)
+    {
+        const auto samplesToNewestFrame = numFramesDue * hopSize - samplesSinceLastFrame;
+        readIntoAnalysisBuffer(samplesToNewestFrame);
+
+        fftDataGenerator.produceFFTDataForRendering(analysisBuffer, writePosition, -48.f);
+
+        readIntoAnalysisBuffer(numAvailable - samplesToNewestFrame);
+        samplesSinceLastFrame = numAvailable - samplesToNewestFrame;
+    }
+    else
+    {
+        readIntoAnalysisBuffer(numAvailable);
+        samplesSinceLastFrame += numAvailable;
+    }
+
+    // if there are FFT data buffers that can be pulled
+    // pull all available
+    //generate a path
+
+    //const auto fftBounds = getAnalysisArea().toFloat();
+    const auto numBins = fftSize / 2;
+
+    // 48000 / 2048 = 23hz <-- sample rate / number of bins = bin width
+    //const auto binWidth = audioProcessor.getSampleRate() / (double)fftSize;
+    // a decimated tap runs at a fraction of the host rate
+    const auto binWidth = sampleRate / leftChannelFifo->getDecimation() / (double)fftSize;
+
+    const auto mode = static_cast<Analyzer_Mode>(analyzerMode->load());
+    const std::array<Spectrum, 2> spectra = (mode == Analyzer_MidSide)
+        ? std::array<Spectrum, 2>{ Spectrum_Mid, Spectrum_Side }
+        : std::array<Spectrum, 2>{ Spectrum_Left, Spectrum_Right };
+
+    const auto renderer = getRenderer();
+    bool newFrame = false;
+
+    while (fftDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    {
+        fftDataGenerator.readFFTData([&](const std::vector<float>& fftData)
+        {
+            auto getSpectrum = [&fftData, numBins](Spectrum spectrum)
             {
-                mag *= lowCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowCut.isBypassed<2>())
+                return std::span<const float>(fftData).subspan(size_t(spectrum * numBins), size_t(numBins));
+            };
+
+            // every frame goes into the spectrogram, it keeps the history rather than the newest frame only
+            if (renderer == Analyzer_SpectrogramRenderer)
             {
-                mag *= lowCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                spectrogram.generateColumn(getSpectrum(spectra[0]), getSpectrum(spectra[1]), fftBounds, scale,
+                    fftSize, binWidth, -48.f);
+                return;
             }
-            if (!lowCut.isBypassed<3>())
+
+            for (size_t i = 0; i < pathGenerators.size(); ++i)
             {
-                mag *= lowCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                const auto spectrum = getSpectrum(spectra[i]);
+                pathGenerators[i].generateColumnLevels(spectrum, fftBounds, fftSize, binWidth, -48.f);
+
+                if (renderer == Analyzer_PathRenderer)
+                {
+                    pathGenerators[i].generatePath();
+                }
             }
+
+            newFrame = true;
+        });
+    }
+
+    // the bitmap renderers only ever need the newest levels, drawn once into the free image
+    if (newFrame && (renderer == Analyzer_BitmapRenderer || renderer == Analyzer_FilledBitmapRenderer))
+    {
+        auto& image = publishedImages.getWriteBuffer();
+        SpectrumRasteriser::prepareImage(image, fftBounds, scale);
+
+        const bool filled = renderer == Analyzer_FilledBitmapRenderer;
+        rasteriser.rasterise(image, pathGenerators[0].getColumnLevels(), scale, juce::Colours::blue, filled);
+        rasteriser.rasterise(image, pathGenerators[1].getColumnLevels(), scale, juce::Colours::skyblue, filled);
+
+        publishedImages.publish();
+    }
+
+    // while there are Paths that can be pulled
+    // pull all available
+    // display the most recent
+
+    // only the newest path is published, the earlier ones go back to their slots unused
+    for (size_t i = 0; i < pathGenerators.size(); ++i)
+    {
+        bool newPath = false;
+        while (pathGenerators[i].getNumPathsAvailable())
+        {
+            newPath = pathGenerators[i].getPath(publishedPaths[i].getWriteBuffer()) || newPath;
         }
-        if (!monoChain.isBypassed<ChainPositions::HighCut>())
+
+        if (newPath)
         {
-            if (!highCut.isBypassed<0>())
+            publishedPaths[i].publish();
+        }
+    }
+}
+
+#if YATBEQ_BENCHMARK_SPECTRUM_RENDERERS
+// times everything each renderer does for one frame of both spectra on the software renderer: building and
+// stroking the paths, or rasterising the levels and blitting the image. the spectra are made up, roughly pink
+// with a few dB of noise, so the paths are about as busy as a real signal makes them
+static void benchmarkSpectrumRenderers(juce::Rectangle<int> area)
+{
+    using namespace juce;
+
+    constexpr int fftSize = 8192;
+    constexpr int numFrames = 200;
+    const auto binWidth = 48000.f / float(fftSize);
+
+    Random random(1);
+    std::vector<float> spectrum(size_t(fftSize / 2));
+    std::array<AnalyzerPathGenerator<Path>, 2> generators;
+
+    for (auto& generator : generators)
+    {
+        for (size_t k = 0; k < spectrum.size(); ++k)
+        {
+            spectrum[k] = jlimit(-48.f, 0.f, -6.f - 3.f * std::log2(float(k + 1)) + 6.f * random.nextFloat());
+        }
+
+        generator.generateColumnLevels(spectrum, area.toFloat(), fftSize, binWidth, -48.f);
+    }
+
+    SpectrumRasteriser rasteriser;
+    Path paths[2];
+
+    for (auto scale : { 1.f, 2.f })
+    {
+        Image target(Image::RGB, roundToInt(area.getWidth() * scale), roundToInt(area.getHeight() * scale), true,
+            SoftwareImageType());
+        Image spectrumImage;
+
+        const auto pathMs = averageMilliseconds(numFrames, [&]
+        {
+            for (int i = 0; i < 2; ++i)
             {
-                mag *= highCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                generators[size_t(i)].generatePath();
+                generators[size_t(i)].getPath(paths[i]);
             }
-            if (!highCut.isBypassed<1>())
+
+            Graphics g(target);
+            g.addTransform(AffineTransform::scale(scale));
+            g.fillAll(Colours::black);
+            g.setColour(Colours::blue);
+            g.strokePath(paths[0], PathStrokeType(1.f));
+            g.setColour(Colours::skyblue);
+            g.strokePath(paths[1], PathStrokeType(1.f));
+        });
+
+        auto timeBitmap = [&](bool filled)
+        {
+            return averageMilliseconds(numFrames, [&]
             {
-                mag *= highCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                SpectrumRasteriser::prepareImage(spectrumImage, area.toFloat(), scale);
+                rasteriser.rasterise(spectrumImage, generators[0].getColumnLevels(), scale, Colours::blue, filled);
+                rasteriser.rasterise(spectrumImage, generators[1].getColumnLevels(), scale, Colours::skyblue, filled);
+
+                Graphics g(target);
+                g.addTransform(AffineTransform::scale(scale));
+                g.fillAll(Colours::black);
+                g.drawImage(spectrumImage, area.withZeroOrigin().toFloat());
+            });
+        };
+
+        const auto bitmapMs = timeBitmap(false);
+        const auto filledBitmapMs = timeBitmap(true);
+
+        Logger::writeToLog(String::formatted("spectrum renderers at %.0fx, %dx%d: path %.3f ms, bitmap %.3f ms, filled bitmap %.3f ms",
+            scale, target.getWidth(), target.getHeight(), pathMs, bitmapMs, filledBitmapMs));
+    }
+}
+#endif
+
+//==============================================================================
+void SpectrumRasteriser::prepareImage(juce::Image& image, juce::Rectangle<float> fftBounds, float scale)
+{
+    const auto width = juce::jmax(1, juce::roundToInt(fftBounds.getWidth() * scale));
+    const auto height = juce::jmax(1, juce::roundToInt(fftBounds.getHeight() * scale));
+
+    if (!image.isValid() || image.getWidth() != width || image.getHeight() != height)
+    {
+        image = juce::Image(juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+    }
+    else
+    {
+        image.clear(image.getBounds());
+    }
+}
+
+void SpectrumRasteriser::rasterise(juce::Image& image, std::span<const float> columnLevels, float scale,
+    juce::Colour colour, bool filled)
+{
+    using namespace juce;
+
+    if (columnLevels.empty())
+    {
+        return;
+    }
+
+    // the levels stop short of the right edge above the Nyquist frequency of a decimated tap
+    const auto width = jmin(image.getWidth(), roundToInt(float(columnLevels.size()) * scale));
+    const auto height = image.getHeight();
+    const auto lastColumn = int(columnLevels.size()) - 1;
+
+    // the level at x image pixels from the left, in image pixels. linear between the logical columns,
+    // so a 2x image gets the same line as a stroked path rather than steps
+    auto levelAt = [&](float x)
+    {
+        const auto column = jlimit(0.f, float(lastColumn), x / scale);
+        const auto index = jmin(int(column), jmax(0, lastColumn - 1));
+        const auto next = jmin(index + 1, lastColumn);
+        const auto a = columnLevels[size_t(index)];
+        const auto b = columnLevels[size_t(next)];
+        return (a + (column - float(index)) * (b - a)) * scale;
+    };
+
+    const auto lineColour = colour.getPixelARGB();
+    const auto halfLineWidth = 0.5f * scale;
+
+    if (filled)
+    {
+        // fades from a third of the line's opacity at the top to nothing at the bottom
+        fillRows.resize(size_t(height));
+        for (int y = 0; y < height; ++y)
+        {
+            fillRows[size_t(y)] = colour.withMultipliedAlpha(0.33f * (1.f - float(y) / float(height))).getPixelARGB();
+        }
+    }
+
+    const Image::BitmapData pixels(image, Image::BitmapData::readWrite);
+
+    for (int x = 0; x < width; ++x)
+    {
+        const auto left = levelAt(float(x));
+        const auto right = levelAt(float(x + 1));
+        const auto top = jmax(0.f, jmin(left, right) - halfLineWidth);
+        const auto bottom = jmin(float(height), jmax(left, right) + halfLineWidth);
+
+        const auto firstRow = jmin(height - 1, int(top));
+        const auto lastRow = jmin(height - 1, int(std::ceil(bottom)) - 1);
+
+        if (filled && lastRow + 1 < height)
+        {
+            const auto firstFillRow = jmax(0, lastRow + 1);
+            auto* pixel = reinterpret_cast<PixelARGB*>(pixels.getPixelPointer(x, firstFillRow));
+            for (int y = firstFillRow; y < height; ++y)
+            {
+                pixel->blend(fillRows[size_t(y)]);
+                pixel = addBytesToPointer(pixel, pixels.lineStride);
             }
-            if (!highCut.isBypassed<2>())
+        }
+
+        // the rows the span only partly covers get the line colour scaled by their coverage
+        auto* pixel = reinterpret_cast<PixelARGB*>(pixels.getPixelPointer(x, firstRow));
+        for (int y = firstRow; y <= lastRow; ++y)
+        {
+            const auto coverage = jmin(bottom, float(y + 1)) - jmax(top, float(y));
+
+            if (coverage >= 1.f)
             {
-                mag *= highCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                pixel->blend(lineColour);
             }
-            if (!highCut.isBypassed<3>())
+            else if (coverage > 0.f)
             {
-                mag *= highCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                auto partial = lineColour;
+                partial.multiplyAlpha(coverage);
+                pixel->blend(partial);
             }
-        }
 
-        mags[i] = Decibels::gainToDecibels(mag);
+            pixel = addBytesToPointer(pixel, pixels.lineStride);
+        }
     }
+}
 
-    Path responseCurve;
+//==============================================================================
+SpectrogramGenerator::SpectrogramGenerator()
+{
+    using namespace juce;
 
-    const double outputMin = responseArea.getBottom();
-    const double outputMax = responseArea.getY();
-    auto map = [outputMin, outputMax](double input)
+    ColourGradient gradient;
+    gradient.addColour(0.0, Colours::black);
+    gradient.addColour(0.25, Colours::blue);
+    gradient.addColour(0.5, Colour(97u, 18u, 167u));
+    gradient.addColour(0.75, Colour(255u, 154u, 1u));
+    gradient.addColour(1.0, Colours::white);
+
+    for (size_t i = 0; i < colourTable.size(); ++i)
     {
-        return jmap(input, -24.0, 24.0, outputMin, outputMax);
-    };
+        colourTable[i] = gradient.getColourAtPosition(double(i) / double(colourTable.size() - 1)).getPixelARGB();
+    }
+}
 
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+void SpectrogramGenerator::generateColumn(std::span<const float> first, std::span<const float> second,
+    juce::Rectangle<float> fftBounds, float scale, int fftSize, float binWidth, float negativeInfinity)
+{
+    const auto ringWidth = juce::roundToInt(fftBounds.getWidth() * scale);
+    const auto height = juce::roundToInt(fftBounds.getHeight() * scale);
 
-    for (size_t i = 1; i < mags.size(); ++i)
+    if (ringWidth <= 0 || height <= 0)
     {
-        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
+        return;
     }
 
-    if (shouldShowFFTAnalysis)
+    rowBins.update(height, fftSize / 2, binWidth);
+
+    const auto toIndex = float(colourTable.size() - 1) / -negativeInfinity;
+
+    // the rows above the Nyquist frequency of a decimated tap get the colour of the floor
+    const auto numRowsBelowNyquist = rowBins.getNumPixelsBelowNyquist();
+
+    // a full fifo means the message thread stalled, the column is dropped like a frame the display never showed
+    columnFifo.write([&](Column& column)
     {
-        juce::Path leftChannelFFTPath = leftPathProducer.getPath();
-        juce::Path rightChannelFFTPath = rightPathProducer.getPath();
+        column.pixels.resize(size_t(height));
+        column.ringWidth = ringWidth;
+        column.scale = scale;
 
-        leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
-        rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
+        for (int row = numRowsBelowNyquist; row < height; ++row)
+        {
+            column.pixels[size_t(height - 1 - row)] = colourTable[0];
+        }
 
-        g.setColour(Colours::blue);
-        g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
-        g.setColour(Colours::skyblue);
-        g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+        for (int row = 0; row < numRowsBelowNyquist; ++row)
+        {
+            const auto level = juce::jmax(rowBins.reduce(first, row, LogFrequencyBinMap::Reduction::Max),
+                rowBins.reduce(second, row, LogFrequencyBinMap::Reduction::Max));
+            const auto index = juce::jlimit(0, int(colourTable.size() - 1), int((level - negativeInfinity) * toIndex));
+
+            column.pixels[size_t(height - 1 - row)] = colourTable[size_t(index)];
+        }
+    });
+}
+
+bool SpectrogramGenerator::pullColumns()
+{
+    using namespace juce;
+
+    bool newColumns = false;
+
+    while (columnFifo.getNumAvailableForReading() > 0)
+    {
+        columnFifo.read([this, &newColumns](const Column& column)
+        {
+            const auto height = int(column.pixels.size());
+
+            // a new size starts the history over
+            if (!ring.isValid() || ring.getWidth() != column.ringWidth || ring.getHeight() != height)
+            {
+                ring = Image(Image::ARGB, column.ringWidth, height, false, SoftwareImageType());
+                ring.clear(ring.getBounds(), Colours::black);
+                writeColumn = 0;
+            }
+
+            ringScale = column.scale;
+
+            const Image::BitmapData pixels(ring, writeColumn, 0, 1, height, Image::BitmapData::writeOnly);
+            for (int y = 0; y < height; ++y)
+            {
+                *reinterpret_cast<PixelARGB*>(pixels.getLinePointer(y)) = column.pixels[size_t(y)];
+            }
+
+            writeColumn = (writeColumn + 1) % ring.getWidth();
+            newColumns = true;
+        });
     }
 
-    g.setColour(Colours::orange);
-    g.drawRoundedRectangle(getAnalysisArea().toFloat(), 4.f, 1.f);
-    //g.setColour(Colours::red);
-    //g.drawRoundedRectangle(getRenderedArea().toFloat(), 4.f, 1.f);
-    //g.setColour(Colours::green);
-    //g.drawRoundedRectangle(getLocalBounds().toFloat(), 4.f, 1.f);
+    return newColumns;
+}
 
-    g.setColour(Colours::white);
-    g.strokePath(responseCurve, PathStrokeType(2.f));
+void SpectrogramGenerator::draw(juce::Graphics& g, juce::Rectangle<float> area) const
+{
+    using namespace juce;
+
+    if (!ring.isValid())
+    {
+        return;
+    }
+
+    // writeColumn is the oldest column. the first blit puts it at the left edge, the second wraps the columns
+    // before it round to the right. whatever falls outside the area is clipped away
+    const Graphics::ScopedSaveState state(g);
+    g.reduceClipRegion(area.toNearestInt());
+
+    const auto toArea = AffineTransform::scale(1.f / ringScale);
+    const auto oldestX = area.getX() - float(writeColumn) / ringScale;
+
+    g.drawImageTransformed(ring, toArea.translated(oldestX, area.getY()));
+    g.drawImageTransformed(ring, toArea.translated(oldestX + float(ring.getWidth()) / ringScale, area.getY()));
 }
 
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+//==============================================================================
+AnalyzerThread::AnalyzerThread(std::initializer_list<PathProducer*> producersToRun) :
+    juce::Thread("YATBEQ Analyzer"),
+    producers(producersToRun)
 {
-    parametersChanged.set(true);
 }
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+AnalyzerThread::~AnalyzerThread()
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
+    stopThread(1000);
+}
 
-    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
+void AnalyzerThread::setAnalysisArea(juce::Rectangle<float> newArea, double newSampleRate, float newScale)
+{
+    const juce::SpinLock::ScopedLockType lock(areaLock);
+    analysisArea = newArea;
+    sampleRate = newSampleRate;
+    scale = newScale;
+}
+
+void AnalyzerThread::run()
+{
+    constexpr int intervalMs = 1000 / 60;
+
+    while (!threadShouldExit())
     {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
+        juce::Rectangle<float> area;
+        double rate = 0;
+        float displayScale = 1;
         {
-            auto size = tempIncomingBuffer.getNumSamples();
+            const juce::SpinLock::ScopedLockType lock(areaLock);
+            area = analysisArea;
+            rate = sampleRate;
+            displayScale = scale;
+        }
 
-            // shift "old" data out
-            juce::FloatVectorOperations::copy(
-                monoBuffer.getWritePointer(0, 0),
-                monoBuffer.getReadPointer(0, size),
-                monoBuffer.getNumSamples() - size);
+        if (enabled && !area.isEmpty() && rate > 0)
+        {
+            for (auto* producer : producers)
+            {
+                producer->process(area, rate, displayScale);
+            }
+        }
+
+        wait(intervalMs);
+    }
+}
 
-            // shift "new" data in
-            juce::FloatVectorOperations::copy(
-                monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                tempIncomingBuffer.getReadPointer(0, 0),
-                size);
 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+void ResponseCurveComponent::timerCallback()
+{
+    const auto scale = juce::Component::getApproximateScaleFactorForComponent(this);
 
+    // the analyzer thread does the FFTs and builds the paths, this only picks up what it published
+    if (shouldShowFFTAnalysis)
+    {
+        // the area only changes in resized(), the sample rate and the display scale can change under us
+        analyzerThread.setAnalysisArea(getAnalysisArea().toFloat(), audioProcessor.getSampleRate(), scale);
+
+        // a new spectrum only touches the analysis area
+        if (pathProducer.pullPaths())
+        {
+            repaint(getAnalysisArea());
         }
     }
-    // if there are FFT data buffers that can be pulled
-    // pull all available
-    //generate a path
 
-    //const auto fftBounds = getAnalysisArea().toFloat();
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+    // the sample rate check catches the host changing it without any parameter moving
+    if (parametersChanged.compareAndSetBool(false, true) || audioProcessor.getSampleRate() != responseSampleRate)
+    {
+        // update whichever band caches the change touched and re-rasterise the curve layer.
+        // the curve can overshoot the analysis area, so this repaints the whole component
+        updateResponseCurve();
+        repaint();
+    }
+    else if (scale != responseCurveLayerScale)
+    {
+        // same curve, but the window moved to a display with another scale, like RotarySliderWithLabels' staticLayer
+        renderResponseCurveLayer();
+        repaint();
+    }
+}
 
-    // 48000 / 2048 = 23hz <-- sample rate / number of bins = bin width
-    //const auto binWidth = audioProcessor.getSampleRate() / (double)fftSize;
-    const auto binWidth = sampleRate / (double)fftSize;
+void ResponseCurveComponent::updateResponseCurve(bool areaChanged)
+{
+    using namespace juce;
+
+    const auto chainSettings = getTreeStateChainSettings(audioProcessor.apvts);
+    const auto sampleRate = audioProcessor.getSampleRate();
+    const auto responseArea = getAnalysisArea();
+    const auto w = responseArea.getWidth();
 
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    if (w <= 0)
     {
-        std::vector<float> fftData;
-        if (leftChannelFFTDataGenerator.getFFTData(fftData))
+        return;
+    }
+
+    // a new width or sample rate invalidates every band, otherwise only the bands whose settings moved
+    const bool recomputeAll = w != int(totalMagnitudes.size()) || sampleRate != responseSampleRate;
+
+    if (recomputeAll)
+    {
+        columnFrequencies.resize(size_t(w));
+        for (int i = 0; i < w; ++i)
         {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+            columnFrequencies[size_t(i)] = mapToLog10(double(i) / double(w), 20.0, 20000.0);
         }
+
+        hostRateResponse.prepare(columnFrequencies, sampleRate);
     }
 
-    // while there are Paths that can be pulled
-    // pull all available
-    // display the most recent
+    // the Oversampling parameter moves the peak and high cut to another design rate
+    const auto oversampledRate = getOversampledRate(chainSettings, sampleRate);
+    const bool oversamplingChanged = recomputeAll || oversampledRate != oversampledResponse.getSampleRate();
 
-    while (pathProducer.getNumPathsAvailable())
+    if (oversamplingChanged)
     {
-        pathProducer.getPath(leftChannelFFTPath);
+        oversampledResponse.prepare(columnFrequencies, oversampledRate);
     }
-}
 
+    const std::array<bool, NumResponseBands> bandChanged
+    {
+        recomputeAll || chainSettings.lowCutFreq != responseSettings.lowCutFreq
+            || chainSettings.lowCutSlope != responseSettings.lowCutSlope
+            || chainSettings.lowCutBypassed != responseSettings.lowCutBypassed,
+        oversamplingChanged || chainSettings.peakFreq != responseSettings.peakFreq
+            || chainSettings.peakGainInDecibels != responseSettings.peakGainInDecibels
+            || chainSettings.peakQuality != responseSettings.peakQuality
+            || chainSettings.peakBypassed != responseSettings.peakBypassed,
+        oversamplingChanged || chainSettings.highCutFreq != responseSettings.highCutFreq
+            || chainSettings.highCutSlope != responseSettings.highCutSlope
+            || chainSettings.highCutBypassed != responseSettings.highCutBypassed,
+    };
 
-void ResponseCurveComponent::timerCallback()
-{
-    if (shouldShowFFTAnalysis)
+    if (!areaChanged && std::none_of(bandChanged.begin(), bandChanged.end(), [](bool changed) { return changed; }))
     {
-        auto fftBounds = getAnalysisArea().toFloat();
-        auto sampleRate = audioProcessor.getSampleRate();
-        leftPathProducer.process(fftBounds, sampleRate);
-        rightPathProducer.process(fftBounds, sampleRate);
+        return;
     }
 
-    if (parametersChanged.compareAndSetBool(false, true))
+    responseSettings = chainSettings;
+    responseSampleRate = sampleRate;
+
+    totalMagnitudes.assign(size_t(w), 0.0);
+
+    for (int band = 0; band < NumResponseBands; ++band)
     {
-        // update the mono chain
-        updateChain();
+        auto& mags = bandMagnitudes[size_t(band)];
 
-        // signal a repaint
-        //repaint();
+        if (bandChanged[size_t(band)])
+        {
+            mags.resize(size_t(w));
+            computeBandMagnitudes(static_cast<ResponseBand>(band), chainSettings, mags);
+        }
+
+        // the bands are in series, so their dB responses add
+        for (int i = 0; i < w; ++i)
+        {
+            totalMagnitudes[size_t(i)] += mags[size_t(i)];
+        }
+    }
+
+    const double outputMin = responseArea.getBottom();
+    const double outputMax = responseArea.getY();
+    auto map = [outputMin, outputMax](double input)
+    {
+        return jmap(input, -24.0, 24.0, outputMin, outputMax);
+    };
+
+    responseCurve.clear();
+    responseCurve.startNewSubPath(responseArea.getX(), map(totalMagnitudes.front()));
+
+    for (size_t i = 1; i < totalMagnitudes.size(); ++i)
+    {
+        responseCurve.lineTo(responseArea.getX() + i, map(totalMagnitudes[i]));
     }
 
-    repaint();
+    renderResponseCurveLayer();
 }
 
-void ResponseCurveComponent::updateChain()
+void ResponseCurveComponent::computeBandMagnitudes(ResponseBand band, const ChainSettings& chainSettings, std::vector<double>& mags)
 {
-    auto chainSettings = getTreeStateChainSettings(audioProcessor.apvts);
+    // same sections the audio thread runs: low cut at the host rate, peak and high cut at the oversampled rate
+    switch (band)
+    {
+        case ResponseBand_LowCut:
+            if (!chainSettings.lowCutBypassed)
+            {
+                CutCoefficients lowCut;
+                designLowCutFilter(lowCut, chainSettings, hostRateResponse.getSampleRate());
+                hostRateResponse.evaluate(std::span(lowCut).first(size_t(chainSettings.lowCutSlope + 1)), mags);
+                return;
+            }
+            break;
 
-    monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+        case ResponseBand_Peak:
+            if (!chainSettings.peakBypassed)
+            {
+                BiquadCoefficients peak;
+                designPeakFilter(peak, chainSettings, oversampledResponse.getSampleRate());
+                oversampledResponse.evaluate(std::span(&peak, 1), mags);
+                return;
+            }
+            break;
 
-    auto peakCoefficients = makeThisPeakFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficients(monoChain.get < ChainPositions::Peak>().coefficients, peakCoefficients);
+        case ResponseBand_HighCut:
+            if (!chainSettings.highCutBypassed)
+            {
+                CutCoefficients highCut;
+                designHighCutFilter(highCut, chainSettings, oversampledResponse.getSampleRate());
+                oversampledResponse.evaluate(std::span(highCut).first(size_t(chainSettings.highCutSlope + 1)), mags);
+                return;
+            }
+            break;
 
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
+        case NumResponseBands:
+        default:
+            break;
+    }
 
-    updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+    // bypassed
+    std::fill(mags.begin(), mags.end(), 0.0);
 }
 
 void ResponseCurveComponent::resized()
@@ -566,6 +1250,12 @@ void ResponseCurveComponent::resized()
 
         g.drawFittedText(str, r, juce::Justification::centred, 1);
     }
+
+    updateResponseCurve(true);
+
+   #if YATBEQ_BENCHMARK_SPECTRUM_RENDERERS
+    benchmarkSpectrumRenderers(getAnalysisArea());
+   #endif
 }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderedArea()
@@ -616,7 +1306,8 @@ YATBEQAudioProcessorEditor::YATBEQAudioProcessorEditor (YATBEQAudioProcessor& p)
 	lowCutBypassedButtonAttachment(audioProcessor.apvts, "LowCut Bypassed", lowCutBypassedButton),
     peakBypassedButtonAttachment(audioProcessor.apvts, "Peak Bypassed", peakBypassedButton),
     highCutBypassedButtonAttachment(audioProcessor.apvts, "HighCut Bypassed", highCutBypassedButton),
-    analyzerEnabledButtonAttachment(audioProcessor.apvts, "Analyzer Enabled", analyzerEnabledButton)
+    analyzerEnabledButtonAttachment(audioProcessor.apvts, "Analyzer Enabled", analyzerEnabledButton),
+    analyzerPeakHoldButtonAttachment(audioProcessor.apvts, "Analyzer Peak Hold", analyzerPeakHoldButton)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
@@ -647,12 +1338,46 @@ YATBEQAudioProcessorEditor::YATBEQAudioProcessorEditor (YATBEQAudioProcessor& p)
         addAndMakeVisible(comp);
     }
 
+    processingLoadLabel.setJustificationType(juce::Justification::centredRight);
+    processingLoadLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(processingLoadLabel);
+
     lowCutBypassedButton.setLookAndFeel(&lnf);
     peakBypassedButton.setLookAndFeel(&lnf);
     highCutBypassedButton.setLookAndFeel(&lnf);
 
     analyzerEnabledButton.setLookAndFeel(&lnf);
 
+    // the items have to be there before the attachment picks the selected one.
+    // itemPrefix names the setting where the choices alone ("Off") wouldn't
+    auto attachComboBox = [this](juce::ComboBox& box, std::unique_ptr<ComboBoxAttachment>& attachment, const juce::String& parameterID,
+        const juce::String& itemPrefix)
+    {
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter(parameterID)))
+        {
+            for (int i = 0; i < choice->choices.size(); ++i)
+            {
+                box.addItem(itemPrefix + choice->choices[i], i + 1);
+            }
+        }
+
+        attachment = std::make_unique<ComboBoxAttachment>(audioProcessor.apvts, parameterID, box);
+        addAndMakeVisible(box);
+    };
+
+    attachComboBox(analyzerFFTSizeBox, analyzerFFTSizeBoxAttachment, "Analyzer FFT Size", {});
+    attachComboBox(analyzerWindowBox, analyzerWindowBoxAttachment, "Analyzer Window", {});
+    attachComboBox(analyzerModeBox, analyzerModeBoxAttachment, "Analyzer Mode", {});
+
+    attachComboBox(analyzerRendererBox, analyzerRendererBoxAttachment, "Analyzer Renderer", {});
+    attachComboBox(analyzerAveragingBox, analyzerAveragingBoxAttachment, "Analyzer Averaging", "Averaging ");
+    attachComboBox(analyzerSmoothingBox, analyzerSmoothingBoxAttachment, "Analyzer Smoothing", "Smoothing ");
+    attachComboBox(analyzerDecimationBox, analyzerDecimationBoxAttachment, "Analyzer Decimation", "Decimation ");
+    attachComboBox(analyzerOverlapBox, analyzerOverlapBoxAttachment, "Analyzer Overlap", "Overlap ");
+
+    analyzerPeakHoldButton.setColour(juce::ToggleButton::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(analyzerPeakHoldButton);
+
     auto safePtr = juce::Component::SafePointer<YATBEQAudioProcessorEditor>(this);
     peakBypassedButton.onClick = [safePtr]()
     {
@@ -694,7 +1419,9 @@ YATBEQAudioProcessorEditor::YATBEQAudioProcessorEditor (YATBEQAudioProcessor& p)
         }
     };
 
-    setSize (600, 480);
+    setSize (600, 510);
+
+    startTimerHz(4);
 }
 
 
@@ -707,6 +1434,13 @@ YATBEQAudioProcessorEditor::~YATBEQAudioProcessorEditor()
     analyzerEnabledButton.setLookAndFeel(nullptr);
 }
 
+void YATBEQAudioProcessorEditor::timerCallback()
+{
+    juce::String str;
+    str << "DSP " << juce::String(audioProcessor.getProcessingLoad() * 100.0, 1) << "%";
+    processingLoadLabel.setText(str, juce::dontSendNotification);
+}
+
 //==============================================================================
 void YATBEQAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -724,12 +1458,33 @@ void YATBEQAudioProcessorEditor::resized()
     auto bounds = getLocalBounds();
 
     auto analyzerEnabledArea = bounds.removeFromTop(25);
+    processingLoadLabel.setBounds(analyzerEnabledArea.withLeft(analyzerEnabledArea.getRight() - 80));
     analyzerEnabledArea.setWidth(100);
     analyzerEnabledArea.setX(5);
     analyzerEnabledArea.removeFromTop(2);
 
     analyzerEnabledButton.setBounds(analyzerEnabledArea);
 
+    auto analyzerSettingsArea = analyzerEnabledArea.withX(analyzerEnabledArea.getRight() + 5);
+    analyzerFFTSizeBox.setBounds(analyzerSettingsArea.withWidth(80));
+    analyzerWindowBox.setBounds(analyzerSettingsArea.withX(analyzerFFTSizeBox.getRight() + 5).withWidth(120));
+    analyzerModeBox.setBounds(analyzerSettingsArea.withX(analyzerWindowBox.getRight() + 5).withWidth(100));
+    analyzerPeakHoldButton.setBounds(analyzerSettingsArea.withX(analyzerModeBox.getRight() + 5).withWidth(90));
+
+    bounds.removeFromTop(5);
+
+    auto analyzerDisplayArea = bounds.removeFromTop(25);
+    analyzerDisplayArea.removeFromLeft(5);
+    analyzerRendererBox.setBounds(analyzerDisplayArea.removeFromLeft(110));
+    analyzerDisplayArea.removeFromLeft(5);
+    analyzerAveragingBox.setBounds(analyzerDisplayArea.removeFromLeft(115));
+    analyzerDisplayArea.removeFromLeft(5);
+    analyzerSmoothingBox.setBounds(analyzerDisplayArea.removeFromLeft(140));
+    analyzerDisplayArea.removeFromLeft(5);
+    analyzerDecimationBox.setBounds(analyzerDisplayArea.removeFromLeft(105));
+    analyzerDisplayArea.removeFromLeft(5);
+    analyzerOverlapBox.setBounds(analyzerDisplayArea.removeFromLeft(95));
+
     bounds.removeFromTop(5);
 
     float hRatio = 23.f / 100.f;// JUCE_LIVE_CONSTANT(33) / 100.f;
@@ -754,6 +1509,14 @@ void YATBEQAudioProcessorEditor::resized()
     peakFreqSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.33));
     peakGainSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.5));
     peakQualitySlider.setBounds(bounds);
+
+   #if YATBEQ_BENCHMARK_KNOB_RENDERING
+    for (auto* slider : { &peakFreqSlider, &peakGainSlider, &peakQualitySlider, &lowCutFreqSlider, &highCutFreqSlider,
+        &lowCutSlopeSlider, &highCutSlopeSlider })
+    {
+        slider->benchmarkRendering();
+    }
+   #endif
 }
 
 std::vector<juce::Component*> YATBEQAudioProcessorEditor::getComps()
@@ -11,11 +11,48 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
+#include <bit>
+#include <numeric>
+
+// 1 logs the frame time of each analyzer renderer at 1x and 2x display scale whenever the response curve
+// is resized. off in normal builds, set it in the exporter's preprocessor definitions
+#ifndef YATBEQ_BENCHMARK_SPECTRUM_RENDERERS
+ #define YATBEQ_BENCHMARK_SPECTRUM_RENDERERS 0
+#endif
+
+// 1 logs what a repaint of each knob costs with and without its cached layer, at 1x and 2x display scale,
+// whenever the editor is resized
+#ifndef YATBEQ_BENCHMARK_KNOB_RENDERING
+ #define YATBEQ_BENCHMARK_KNOB_RENDERING 0
+#endif
+
 enum FFTOrder
 {
     order2048 = 11, order4096 = 12, order8192 = 13
 };
 
+static_assert((1 << FFTOrder::order8192) == SingleChannelSampleFifo::maxFFTSize,
+    "the analyzer taps are sized for the largest FFT");
+
+// 20 * log10(gain) from the float's exponent plus a cubic fit of log2 of its mantissa, within 0.01 dB.
+// branch free and table free, so a loop over it vectorises. zero and denormals come out far below any display floor
+forcedinline float fastGainToDecibels(float gain) noexcept
+{
+    const auto bits = std::bit_cast<juce::uint32>(gain);
+    const auto exponent = float(int(bits >> 23) - 127);
+    const auto t = std::bit_cast<float>((bits & 0x007fffffu) | 0x3f800000u) - 1.f;
+    const auto log2Mantissa = t * (1.4234902f + t * (-0.5877535f + t * 0.1655761f));
+
+    // 20 * log10(2)
+    return 6.0205999f * (exponent + log2Mantissa);
+}
+
+// the spectra in every FFTDataGenerator frame, numBins values each, in this order
+enum Spectrum
+{
+    Spectrum_Left, Spectrum_Right, Spectrum_Mid, Spectrum_Side, NumSpectra
+};
+
 template<typename BlockType>
 struct FFTDataGenerator
 {
@@ -24,32 +61,113 @@ struct FFTDataGenerator
         order = FFTOrder::order2048;
     }
 
-    // produces the FFT data from an audio buffer
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    // produces all four spectra from a stereo ring of getFFTSize() samples whose oldest sample is at
+    // oldestSample, straight into the next free frame slot. if the reader is a whole fifo behind, the frame is dropped
+    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, int oldestSample, const float negativeInfinity)
     {
+        jassert(audioData.getNumChannels() >= 2);
+        jassert(audioData.getNumSamples() == getFFTSize());
+
         const auto fftSize = getFFTSize();
 
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+        fftDataFifo.write([this, &audioData, oldestSample, fftSize, negativeInfinity](BlockType& fftData)
+        {
+            using Complex = std::complex<float>;
 
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());
+            // one windowing pass for both channels: left goes into the real parts and right into the
+            // imaginary parts of a single complex frame, so one FFT transforms the pair.
+            // the ring is unrolled on the way in, the part from oldestSample to the end first
+            auto* left = audioData.getReadPointer(0);
+            auto* right = audioData.getReadPointer(1);
 
-        int numBins = (int)fftSize / 2;
+            const auto numToEnd = fftSize - oldestSample;
 
-        //normalize the fft values
-        for (int i = 0; i < numBins; ++i)
+            for (int i = 0; i < numToEnd; ++i)
+            {
+                timeData[i] = Complex(left[oldestSample + i] * windowTable[i], right[oldestSample + i] * windowTable[i]);
+            }
+
+            for (int i = numToEnd; i < fftSize; ++i)
+            {
+                timeData[i] = Complex(left[i - numToEnd] * windowTable[i], right[i - numToEnd] * windowTable[i]);
+            }
+
+            forwardFFT->perform(timeData.data(), frequencyData.data(), false);
+
+            int numBins = (int)fftSize / 2;
+
+            // both inputs are real, so their spectra separate out of Z[k] and conj(Z[N - k]).
+            // mid and side are linear in left and right, their spectra come from the same bins
+            for (int k = 0; k < numBins; ++k)
+            {
+                const auto z = frequencyData[k];
+                const auto zMirror = std::conj(frequencyData[(fftSize - k) & (fftSize - 1)]);
+
+                const auto leftBin = (z + zMirror) * 0.5f;
+                const auto rightBin = (z - zMirror) * Complex(0.f, -0.5f);
+
+                fftData[Spectrum_Left * numBins + k] = std::abs(leftBin);
+                fftData[Spectrum_Right * numBins + k] = std::abs(rightBin);
+                fftData[Spectrum_Mid * numBins + k] = std::abs((leftBin + rightBin) * 0.5f);
+                fftData[Spectrum_Side * numBins + k] = std::abs((leftBin - rightBin) * 0.5f);
+            }
+
+            if (smoothingFraction > 0)
+            {
+                for (int spectrum = 0; spectrum < NumSpectra; ++spectrum)
+                {
+                    smoothOctaveBands(fftData.data() + spectrum * numBins, numBins);
+                }
+            }
+
+            if (std::exchange(displayStateNeedsReset, false))
+            {
+                std::fill(averagedData.begin(), averagedData.end(), negativeInfinity);
+                std::fill(peakData.begin(), peakData.end(), negativeInfinity);
+            }
+
+            // normalise, convert to decibels, average and hold peaks in one pass. switched off averaging
+            // is a coefficient of 1 and switched off peak hold is an infinite decay, so there are no branches
+            const auto normaliser = 1.f / (float)numBins;
+            const auto averagingCoefficient = averaging;
+            const auto peakDecay = holdPeaks ? peakDecayPerFrame : std::numeric_limits<float>::infinity();
+
+            auto* bins = fftData.data();
+            auto* averaged = averagedData.data();
+            auto* peaks = peakData.data();
+
+            for (int i = 0; i < NumSpectra * numBins; ++i)
+            {
+                auto level = juce::jmax(fastGainToDecibels(bins[i] * normaliser), negativeInfinity);
+
+                level = averaged[i] + averagingCoefficient * (level - averaged[i]);
+                averaged[i] = level;
+
+                level = juce::jmax(peaks[i] - peakDecay, level);
+                peaks[i] = level;
+
+                bins[i] = level;
+            }
+        });
+    }
+
+    // time and frequency smoothing of the display, from the thread that calls produceFFTDataForRendering().
+    // averagingCoefficient is the weight of the newest frame (1 is off), octaveFraction is N for 1/N octave smoothing (0 is off)
+    void setDisplayProcessing(float averagingCoefficient, bool shouldHoldPeaks, int octaveFraction)
+    {
+        if (holdPeaks != shouldHoldPeaks || averaging != averagingCoefficient)
         {
-            fftData[i] /= (float)numBins;
+            displayStateNeedsReset = true;
         }
 
-        // convert to decibels
-        for (int i = 0; i < numBins; ++i)
+        averaging = averagingCoefficient;
+        holdPeaks = shouldHoldPeaks;
+
+        if (octaveFraction != smoothingFraction)
         {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+            smoothingFraction = octaveFraction;
+            updateSmoothingRanges();
         }
-        fftDataFifo.push(fftData);
     }
 
     void changeOrder(FFTOrder newOrder)
@@ -63,123 +181,470 @@ struct FFTDataGenerator
         auto fftSize = getFFTSize();
 
         forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
 
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
-        fftDataFifo.prepare(fftData.size());
+        windowTable.resize(size_t(fftSize));
+        changeWindow(windowType);
+
+        timeData.resize(size_t(fftSize));
+        frequencyData.resize(size_t(fftSize));
+
+        // NumSpectra half spectra per frame slot
+        fftDataFifo.prepare(size_t(NumSpectra * fftSize / 2));
+
+        averagedData.resize(size_t(NumSpectra * fftSize / 2));
+        peakData.resize(size_t(NumSpectra * fftSize / 2));
+        displayStateNeedsReset = true;
+
+        prefixSums.resize(size_t(fftSize / 2 + 1));
+        updateSmoothingRanges();
+    }
+
+    // the averaged and held levels start again from the next frame, for when the input changes under them
+    void resetDisplayProcessing() { displayStateNeedsReset = true; }
+    void changeWindow(juce::dsp::WindowingFunction<float>::WindowingMethod newWindowType)
+    {
+        windowType = newWindowType;
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(windowTable.data(), windowTable.size(), windowType, true);
     }
     //====================================================================================
     int getFFTSize() const { return 1 << order; }
     int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
     //====================================================================================
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+    // hands the oldest frame to callback(const BlockType&) without copying it, then frees its slot
+    template<typename Callback>
+    bool readFFTData(Callback&& callback)
+    {
+        return fftDataFifo.read([&callback](const BlockType& fftData) { callback(fftData); });
+    }
 private:
     FFTOrder order;
-    BlockType fftData;
     std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    juce::dsp::WindowingFunction<float>::WindowingMethod windowType = juce::dsp::WindowingFunction<float>::blackmanHarris;
+    std::vector<float> windowTable;
+    std::vector<std::complex<float>> timeData, frequencyData;
 
     Fifo<BlockType> fftDataFifo;
+
+    // display processing state, NumSpectra * numBins values in dB
+    static constexpr float peakDecayPerFrame = 0.5f;
+    float averaging = 1.f;
+    bool holdPeaks = false;
+    bool displayStateNeedsReset = true;
+    std::vector<float> averagedData, peakData;
+
+    // 1/smoothingFraction octave smoothing: bin k averages the magnitudes of bins
+    // smoothingLow[k] to smoothingHigh[k] inclusive, read off a running sum in O(1) per bin
+    int smoothingFraction = 0;
+    std::vector<int> smoothingLow, smoothingHigh;
+    std::vector<double> prefixSums;
+
+    void updateSmoothingRanges()
+    {
+        if (smoothingFraction <= 0 || !forwardFFT)
+        {
+            return;
+        }
+
+        const auto numBins = getFFTSize() / 2;
+        const auto halfBandwidth = std::pow(2.0, 0.5 / smoothingFraction);
+
+        smoothingLow.resize(size_t(numBins));
+        smoothingHigh.resize(size_t(numBins));
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            smoothingLow[size_t(k)] = juce::jlimit(0, k, int(std::floor(k / halfBandwidth)));
+            smoothingHigh[size_t(k)] = juce::jlimit(k, numBins - 1, int(std::ceil(k * halfBandwidth)));
+        }
+    }
+
+    void smoothOctaveBands(float* bins, int numBins)
+    {
+        prefixSums[0] = 0;
+        for (int k = 0; k < numBins; ++k)
+        {
+            prefixSums[size_t(k + 1)] = prefixSums[size_t(k)] + bins[k];
+        }
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            const auto low = smoothingLow[size_t(k)];
+            const auto high = smoothingHigh[size_t(k)];
+            bins[k] = float((prefixSums[size_t(high + 1)] - prefixSums[size_t(low)]) / (high - low + 1));
+        }
+    }
 };
 
 //=====================================================================================================
+// the FFT bins under each of numPixels pixels spread over 20Hz to 20kHz on a log scale, pixel 0 at 20Hz.
+// rebuilt only when the pixel count, the FFT size or the bin width changes. with a decimated tap the spectrum
+// ends below 20kHz, the pixels from getNumPixelsBelowNyquist() on have no bins and are left blank by the renderers
+struct LogFrequencyBinMap
+{
+    // which value of the bins under a pixel is used. Max keeps narrow high frequency peaks
+    // that share a pixel with hundreds of other bins
+    enum class Reduction
+    {
+        Max, Mean, Min
+    };
+
+    void update(int numPixels, int numBins, float binWidth)
+    {
+        if (numPixels == mappedPixels && numBins == mappedNumBins && binWidth == mappedBinWidth)
+        {
+            return;
+        }
+
+        mappedPixels = numPixels;
+        mappedNumBins = numBins;
+        mappedBinWidth = binWidth;
+
+        pixelBins.resize(size_t(numPixels));
+        pixelsBelowNyquist = 0;
+
+        const auto nyquist = float(numBins) * binWidth;
+
+        for (int x = 0; x < numPixels; ++x)
+        {
+            const auto lowFreq = juce::mapToLog10(float(x) / float(numPixels), 20.f, 20000.f);
+            const auto highFreq = juce::mapToLog10(float(x + 1) / float(numPixels), 20.f, 20000.f);
+
+            if (lowFreq < nyquist)
+            {
+                pixelsBelowNyquist = x + 1;
+            }
+
+            auto& pixel = pixelBins[size_t(x)];
+            pixel.firstBin = juce::jlimit(0, numBins - 1, int(std::ceil(lowFreq / binWidth)));
+            pixel.lastBin = juce::jlimit(0, numBins - 1, int(std::ceil(highFreq / binWidth)) - 1);
+
+            if (pixel.lastBin < pixel.firstBin)
+            {
+                const auto centreBin = std::sqrt(lowFreq * highFreq) / binWidth;
+                pixel.firstBin = juce::jlimit(0, numBins - 2, int(centreBin));
+                pixel.lastBin = pixel.firstBin - 1;
+                pixel.interpolation = juce::jlimit(0.f, 1.f, centreBin - float(pixel.firstBin));
+            }
+        }
+    }
+
+    int getNumPixelsBelowNyquist() const { return pixelsBelowNyquist; }
+
+    float reduce(std::span<const float> data, int pixelIndex, Reduction reduction) const
+    {
+        const auto& pixel = pixelBins[size_t(pixelIndex)];
+
+        if (pixel.lastBin < pixel.firstBin)
+        {
+            const auto a = data[size_t(pixel.firstBin)];
+            const auto b = data[size_t(pixel.firstBin + 1)];
+            return a + pixel.interpolation * (b - a);
+        }
+
+        const auto* first = data.data() + pixel.firstBin;
+        const auto* last = data.data() + pixel.lastBin + 1;
+
+        switch (reduction)
+        {
+            case Reduction::Mean: return std::accumulate(first, last, 0.f) / float(last - first);
+            case Reduction::Min: return *std::min_element(first, last);
+            case Reduction::Max:
+            default: return *std::max_element(first, last);
+        }
+    }
+
+private:
+    // a pixel narrower than a bin has no bin of its own (lastBin < firstBin) and interpolates
+    // between firstBin and the bin after it instead
+    struct PixelBins
+    {
+        int firstBin{ 0 }, lastBin{ 0 };
+        float interpolation{ 0 };
+    };
+
+    std::vector<PixelBins> pixelBins;
+    int pixelsBelowNyquist = 0;
+    int mappedPixels = 0, mappedNumBins = 0;
+    float mappedBinWidth = 0;
+};
+
 template<typename PathType>
 struct AnalyzerPathGenerator
 {
-	// converts renderData[] into juce::Path
-    void generatePath(const std::vector<float>& renderData, juce::Rectangle<float> fftBounds, int fftSize,
+	// maps renderData[] to a y coordinate for each pixel column of fftBounds, what both renderers draw from.
+    // the columns stop at the Nyquist frequency of the tap, so a decimated spectrum ends short of the right edge
+    void generateColumnLevels(std::span<const float> renderData, juce::Rectangle<float> fftBounds, int fftSize,
         float binWidth, float negativeInfinity)
     {
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
-        auto width = fftBounds.getWidth();
+        auto width = (int)fftBounds.getWidth();
 
         int numBins = (int)fftSize / 2;
-        PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+
+        if (width <= 0)
+        {
+            columnLevels.clear();
+            return;
+        }
+
+        columnBins.update(width, numBins, binWidth);
 
         auto map = [bottom, top, negativeInfinity](float v)
         {
             return juce::jmap(v, negativeInfinity, 0.f, float(bottom), top);
         };
 
-        auto y = map(renderData[0]);
+        columnLevels.resize(size_t(columnBins.getNumPixelsBelowNyquist()));
+
+        for (int x = 0; x < int(columnLevels.size()); ++x)
+        {
+            auto y = map(columnBins.reduce(renderData, x, columnReduction));
 
-        jassert(!std::isnan(y) && !std::isinf(y));
+            jassert(!std::isnan(y) && !std::isinf(y));
 
-        p.startNewSubPath(0, y);
+            columnLevels[size_t(x)] = y;
+        }
+    }
 
-        //you can draw line-to's every 'pathResolution' pixels.
-        const int pathResolution = 2;
+    std::span<const float> getColumnLevels() const { return columnLevels; }
 
-        for ( int binNum = 1; binNum < numBins; binNum += pathResolution)
+	// converts the column levels into juce::Path, one point per pixel column
+    void generatePath()
+    {
+        if (columnLevels.empty())
         {
-            y = map(renderData[binNum]);
+            return;
+        }
 
-            jassert(!std::isnan(y) && !std::isinf(y));
+        // built in the next free slot, clear() keeps the storage of whatever path was there before.
+        // the point count is bounded by the width, however many bins the FFT has
+        pathFifo.write([this](PathType& p)
+        {
+            p.clear();
+            p.preallocateSpace(3 * int(columnLevels.size()));
+
+            p.startNewSubPath(0, columnLevels[0]);
 
-            if (!std::isnan(y) && !std::isinf(y))
+            for (size_t x = 1; x < columnLevels.size(); ++x)
             {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
+                p.lineTo(float(x), columnLevels[x]);
             }
-        }
-
-        pathFifo.push(p);
+        });
     }
 
+    // which value of the bins under a pixel column the path follows
+    using ColumnReduction = LogFrequencyBinMap::Reduction;
+
+    ColumnReduction columnReduction = ColumnReduction::Max;
+
     int getNumPathsAvailable() const
     {
         return pathFifo.getNumAvailableForReading();
     }
 
+    // swaps the oldest path into 'path', the slot gets the old one back to reuse its storage
     bool getPath(PathType& path)
     {
-        return pathFifo.pull(path);
+        return pathFifo.read([&path](PathType& p) { path.swapWithPath(p); });
     }
 
 private:
     Fifo<PathType> pathFifo;
+    std::vector<float> columnLevels;
+
+    LogFrequencyBinMap columnBins;
+};
+
+// the bitmap alternative to stroking the analyzer paths. each image column gets one vertical span that covers
+// the line from the level at its left edge to the level at its right edge, written straight into the pixels
+// through BitmapData. the span ends are antialiased by their coverage, the optional fill under the line comes
+// from a gradient looked up per row
+struct SpectrumRasteriser
+{
+    // (re)allocates 'image' for fftBounds at the display scale only when the size changes, clears it otherwise.
+    // always a software image, so the pixels can be written on the analyzer thread
+    static void prepareImage(juce::Image& image, juce::Rectangle<float> fftBounds, float scale);
+
+    // draws a one pixel (at 1x) line through columnLevels, coordinates as produced by generateColumnLevels().
+    // the image columns past the last level are left clear
+    void rasterise(juce::Image& image, std::span<const float> columnLevels, float scale,
+        juce::Colour colour, bool filled);
+
+private:
+    std::vector<juce::PixelARGB> fillRows;
 };
 
+// the spectrogram: one column per FFT frame, newest on the right, 20Hz at the bottom to 20kHz at the top.
+// the analyzer thread turns a frame into a column of pixels through a log frequency row map and a colour table,
+// the message thread copies the column into a ring of columns in an image. scrolling only moves the write column
+// and draw() blits the image in two parts around it, so a frame costs one column whatever the width
+struct SpectrogramGenerator
+{
+    SpectrogramGenerator();
+
+    // analyzer thread: queues the column for a frame of a pair of spectra, the louder of the two per row
+    void generateColumn(std::span<const float> first, std::span<const float> second, juce::Rectangle<float> fftBounds,
+        float scale, int fftSize, float binWidth, float negativeInfinity);
+
+    // message thread: writes the queued columns into the ring, false if there were none
+    bool pullColumns();
+
+    // message thread: the history across 'area', oldest column at the left edge
+    void draw(juce::Graphics& g, juce::Rectangle<float> area) const;
+
+private:
+    struct Column
+    {
+        std::vector<juce::PixelARGB> pixels;
+        int ringWidth = 0;
+        float scale = 1;
+    };
+
+    Fifo<Column> columnFifo;
+
+    // analyzer thread. the map runs bottom to top, row 0 of the image is the last pixel of the map
+    LogFrequencyBinMap rowBins;
 
+    // black through the analyzer's blue, purple and orange to white, over negativeInfinity to 0dB
+    std::array<juce::PixelARGB, 256> colourTable;
+
+    // message thread
+    juce::Image ring;
+    int writeColumn = 0;
+    float ringScale = 1;
+};
+
+// the stereo analyzer: both taps go through one FFTDataGenerator, which produces left, right, mid and side
+// in one pass. paths are built for the pair the "Analyzer Mode" parameter selects
 struct PathProducer
 {
-    PathProducer(SingleChannelSampleFifo<YATBEQAudioProcessor::BlockType>& scsf) :
-        leftChannelFifo(&scsf)
+    PathProducer(YATBEQAudioProcessor& p) :
+        leftChannelFifo(&p.leftChannelFifo),
+        rightChannelFifo(&p.rightChannelFifo),
+        analyzerMode(p.apvts.getRawParameterValue("Analyzer Mode")),
+        analyzerOverlap(p.apvts.getRawParameterValue("Analyzer Overlap")),
+        analyzerFFTSize(p.apvts.getRawParameterValue("Analyzer FFT Size")),
+        analyzerWindow(p.apvts.getRawParameterValue("Analyzer Window")),
+        analyzerAveraging(p.apvts.getRawParameterValue("Analyzer Averaging")),
+        analyzerPeakHold(p.apvts.getRawParameterValue("Analyzer Peak Hold")),
+        analyzerSmoothing(p.apvts.getRawParameterValue("Analyzer Smoothing")),
+        analyzerRenderer(p.apvts.getRawParameterValue("Analyzer Renderer"))
     {
 
         // 48000 / 2048 = 23hz
 
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+        updateAnalysisSettings();
+    }
+    // analyzer thread: drains the fifos, runs the FFTs and publishes the newest pair of paths,
+    // or with a bitmap renderer the newest spectrum image at the display scale
+    void process(juce::Rectangle<float> fftBounds, double sampleRate, float scale);
+
+    // message thread: swaps in the newest published paths or image and takes the new spectrogram columns,
+    // false if nothing new arrived
+    bool pullPaths()
+    {
+        return publishedPaths[0].pull() | publishedPaths[1].pull() | publishedImages.pull() | spectrogram.pullColumns();
     }
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() { return leftChannelFFTPath; }
+
+    // 0 is left or mid, 1 is right or side
+    const juce::Path& getPath(int index) const { return publishedPaths[size_t(index)].getReadBuffer(); }
+
+    // both spectra, covering fftBounds
+    const juce::Image& getSpectrumImage() const { return publishedImages.getReadBuffer(); }
+
+    void drawSpectrogram(juce::Graphics& g, juce::Rectangle<float> area) const { spectrogram.draw(g, area); }
+
+    Analyzer_Renderer getRenderer() const { return static_cast<Analyzer_Renderer>(analyzerRenderer->load()); }
 
 private:
-    SingleChannelSampleFifo<YATBEQAudioProcessor::BlockType>* leftChannelFifo;
-    //SingleChannelSampleFifo<YATBEQAudioProcessor::BlockType>* rightChannelFifo;
+    SingleChannelSampleFifo* leftChannelFifo;
+    SingleChannelSampleFifo* rightChannelFifo;
+    std::atomic<float>* analyzerMode;
+    std::atomic<float>* analyzerOverlap;
+
+    // "Analyzer FFT Size" and "Analyzer Window". only the thread running process() ever rebuilds the FFT,
+    // the window, the frame slots and the analysis ring, so a change can't race a frame in flight
+    std::atomic<float>* analyzerFFTSize;
+    std::atomic<float>* analyzerWindow;
+    int fftSizeIndex = -1, windowIndex = -1;
+
+    // "Analyzer Averaging", "Analyzer Peak Hold" and "Analyzer Smoothing"
+    std::atomic<float>* analyzerAveraging;
+    std::atomic<float>* analyzerPeakHold;
+    std::atomic<float>* analyzerSmoothing;
+
+    // "Analyzer Renderer"
+    std::atomic<float>* analyzerRenderer;
+
+    void updateAnalysisSettings();
+
+    // the STFT input, a ring of the last getFFTSize() samples per channel. writePosition is the oldest sample,
+    // a frame is due every hop samples no matter how the host splits its blocks
+    juce::AudioBuffer<float> analysisBuffer;
+    int writePosition = 0;
+    int samplesSinceLastFrame = 0;
+
+    void readIntoAnalysisBuffer(int numSamples);
+
+    // the ring starts again from silence, the first frames fade in
+    void restartAnalysisBuffer();
+
+    // the decimation the taps were last analysed at. on a change everything already read or queued
+    // at the old rate is dropped, it would otherwise be analysed as if it were at the new one
+    int analysedDecimation = 1;
+
+    FFTDataGenerator <std::vector<float>> fftDataGenerator;
+
+    std::array<AnalyzerPathGenerator<juce::Path>, 2> pathGenerators;
+
+    std::array<TripleBuffer<juce::Path>, 2> publishedPaths;
+
+    SpectrumRasteriser rasteriser;
+    TripleBuffer<juce::Image> publishedImages;
+
+    SpectrogramGenerator spectrogram;
+};
 
-    juce::AudioBuffer<float> monoBuffer;
+// runs the PathProducers at the display rate on its own thread, so the message thread only ever
+// picks up finished paths. one per ResponseCurveComponent, started and stopped with it
+struct AnalyzerThread : juce::Thread
+{
+    AnalyzerThread(std::initializer_list<PathProducer*> producersToRun);
+    ~AnalyzerThread() override;
+
+    // message thread
+    void setAnalysisArea(juce::Rectangle<float> newArea, double newSampleRate, float newScale);
+    void setEnabled(bool shouldBeEnabled) { enabled = shouldBeEnabled; }
+
+    void run() override;
 
-    FFTDataGenerator <std::vector<float>> leftChannelFFTDataGenerator;
+private:
+    std::vector<PathProducer*> producers;
 
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+    juce::SpinLock areaLock;
+    juce::Rectangle<float> analysisArea;
+    double sampleRate{ 0 };
+    float scale{ 1 };
 
-    juce::Path leftChannelFFTPath;
+    std::atomic<bool> enabled{ true };
 };
 
 
 //=====================================================================================================
+struct RotarySliderWithLabels;
+
 struct LookAndFeel : juce::LookAndFeel_V4
 {
     void drawRotarySlider(juce::Graphics&, int x, int y, int width, int height,
         float sliderPosProportional, float rotaryStartAngle, float rotaryEndAngle, juce::Slider&) override;
 
+    // the two halves of drawRotarySlider(): the body that only changes with the size and the enablement,
+    // and the pointer with the value text. RotarySliderWithLabels caches the body and draws the rest per repaint
+    void drawRotarySliderBody(juce::Graphics&, juce::Rectangle<float> bounds, bool enabled);
+    void drawRotarySliderPointer(juce::Graphics&, juce::Rectangle<float> bounds, float sliderPosProportional,
+        float rotaryStartAngle, float rotaryEndAngle, RotarySliderWithLabels&);
+
     void drawToggleButton(juce::Graphics& g, juce::ToggleButton& toggleButton, 
         bool shouldDrawButtonAsHighlighted, bool shouldDrawButtonAsDown) override;
 };
@@ -212,11 +677,30 @@ struct RotarySliderWithLabels : juce::Slider
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const; 
 
+   #if YATBEQ_BENCHMARK_KNOB_RENDERING
+    void benchmarkRendering();
+   #endif
+
 private:
     LookAndFeel lnf;
 
     juce::RangedAudioParameter* param;
     juce::String suffix;
+
+    // 7:30 round to 4:30
+    static constexpr float startAngle = juce::degreesToRadians(180.f + 45.f);
+    static constexpr float endAngle = juce::degreesToRadians(180.f - 45.f) + juce::MathConstants<float>::twoPi;
+
+    void drawLabels(juce::Graphics& g);
+
+    // the knob body and the label ring, rendered at the display scale. rebuilt only when the size, the scale or
+    // the enablement changes, the labels are expected to be added before the first paint
+    juce::Image staticLayer;
+    juce::Rectangle<int> staticLayerBounds;
+    float staticLayerScale = 0;
+    bool staticLayerEnabled = false;
+
+    void updateStaticLayer(float scale);
 };
 
 struct ResponseCurveComponent : juce::Component,
@@ -239,21 +723,46 @@ struct ResponseCurveComponent : juce::Component,
     void toggleAnalysisEnablement(bool enabled)
     {
         shouldShowFFTAnalysis = enabled;
+        analyzerThread.setEnabled(enabled);
+        repaint();
     };
 
 private:
     YATBEQAudioProcessor& audioProcessor;
     juce::Atomic<bool> parametersChanged{ false };
 
-    MonoChain monoChain;
-    void updateChain();
+    // the response curve is built here and only stroked in paint(). each band keeps its own dB per pixel column,
+    // so a parameter change recomputes just the band it belongs to. a new width or sample rate recomputes all of them.
+    // the bands are designed with the processor's own design functions and evaluated in batches over the pixel columns
+    enum ResponseBand
+    {
+        ResponseBand_LowCut, ResponseBand_Peak, ResponseBand_HighCut, NumResponseBands
+    };
+
+    std::array<std::vector<double>, NumResponseBands> bandMagnitudes;
+    std::vector<double> totalMagnitudes;
+    juce::Path responseCurve;
+    ChainSettings responseSettings;
+    double responseSampleRate{ 0 };
+
+    std::vector<double> columnFrequencies;
+    BiquadResponseEvaluator hostRateResponse, oversampledResponse;
+
+    // the curve and the analysis area outline over a transparent background, rasterised at responseCurveLayerScale
+    juce::Image responseCurveLayer;
+    float responseCurveLayerScale = 0;
+    void renderResponseCurveLayer();
+
+    void updateResponseCurve(bool areaChanged = false);
+    void computeBandMagnitudes(ResponseBand band, const ChainSettings& chainSettings, std::vector<double>& mags);
 
     juce::Image background;
 
     juce::Rectangle<int> getRenderedArea();
     juce::Rectangle<int> getAnalysisArea();
 
-    PathProducer leftPathProducer, rightPathProducer;
+    PathProducer pathProducer;
+    AnalyzerThread analyzerThread{ &pathProducer };
 
     bool shouldShowFFTAnalysis = true;
 };
@@ -283,7 +792,8 @@ struct AnalyzerButton : juce::ToggleButton
 //==============================================================================
 /**
 */
-class YATBEQAudioProcessorEditor  : public juce::AudioProcessorEditor
+class YATBEQAudioProcessorEditor  : public juce::AudioProcessorEditor,
+    juce::Timer
 {
 public:
     YATBEQAudioProcessorEditor (YATBEQAudioProcessor&);
@@ -293,6 +803,8 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    void timerCallback() override;
+
 private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
@@ -313,11 +825,28 @@ private:
 
     PowerButton lowCutBypassedButton, peakBypassedButton, highCutBypassedButton;
 	AnalyzerButton analyzerEnabledButton;
+    juce::ToggleButton analyzerPeakHoldButton{ "Peak Hold" };
+
+    // shows audioProcessor.getProcessingLoad(), for comparing the processing modes against each other
+    juce::Label processingLoadLabel;
 
     using ButtonAttachment = APVTS::ButtonAttachment;
 
     ButtonAttachment lowCutBypassedButtonAttachment, peakBypassedButtonAttachment,
-	highCutBypassedButtonAttachment, analyzerEnabledButtonAttachment;
+	highCutBypassedButtonAttachment, analyzerEnabledButtonAttachment, analyzerPeakHoldButtonAttachment;
+
+    // analyzer settings, the attachments are made once the boxes have their items
+    using ComboBoxAttachment = APVTS::ComboBoxAttachment;
+
+    juce::ComboBox analyzerFFTSizeBox, analyzerWindowBox, analyzerModeBox;
+    std::unique_ptr<ComboBoxAttachment> analyzerFFTSizeBoxAttachment, analyzerWindowBoxAttachment,
+        analyzerModeBoxAttachment;
+
+    // the display settings, on a second row under the analyzer settings
+    juce::ComboBox analyzerRendererBox, analyzerAveragingBox, analyzerSmoothingBox, analyzerDecimationBox,
+        analyzerOverlapBox;
+    std::unique_ptr<ComboBoxAttachment> analyzerRendererBoxAttachment, analyzerAveragingBoxAttachment,
+        analyzerSmoothingBoxAttachment, analyzerDecimationBoxAttachment, analyzerOverlapBoxAttachment;
 
     std::vector<juce::Component*> getComps();
 
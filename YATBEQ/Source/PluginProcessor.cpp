@@ -22,10 +22,30 @@ YATBEQAudioProcessor::YATBEQAudioProcessor()
                        )
 #endif
 {
+    chainParameters.attachTo(apvts);
+    smoothingStride = apvts.getRawParameterValue("Smoothing");
+    doublePrecision = apvts.getRawParameterValue("Double Precision");
+    multithreading = apvts.getRawParameterValue("Multithreading");
+    analyzerEnabled = apvts.getRawParameterValue("Analyzer Enabled");
+    analyzerDecimation = apvts.getRawParameterValue("Analyzer Decimation");
+
+    // the analyzer, display and processing mode parameters don't change the design
+    for (auto* parameterID : ChainParameters::parameterIDs)
+    {
+        apvts.getParameter(parameterID)->addListener(this);
+    }
+
+    startTimerHz(4);
 }
 
 YATBEQAudioProcessor::~YATBEQAudioProcessor()
 {
+    stopTimer();
+
+    for (auto* parameterID : ChainParameters::parameterIDs)
+    {
+        apvts.getParameter(parameterID)->removeListener(this);
+    }
 }
 
 //==============================================================================
@@ -91,6 +111,11 @@ void YATBEQAudioProcessor::changeProgramName (int index, const juce::String& new
 }
 
 //==============================================================================
+#if YATBEQ_BENCHMARK_PRECISION || YATBEQ_BENCHMARK_OVERSAMPLING || YATBEQ_BENCHMARK_MULTITHREADING
+// the YATBEQ_BENCHMARK_* blocks that time the processing, logged at the end of prepareToPlay()
+static void runProcessingBenchmarks(double sampleRate, int samplesPerBlock);
+#endif
+
 void YATBEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // Use this method as the place to do any pre-playback
@@ -98,31 +123,109 @@ void YATBEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock
 
     juce::dsp::ProcessSpec spec;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    spec.numChannels = getTotalNumOutputChannels();
     spec.sampleRate = sampleRate;
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    floatChain.prepare(spec);
+    doubleChain.prepare(spec);
+    processingInDouble = doublePrecision->load() > 0.5f;
+
+    doublePrecisionBuffer.setSize(juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()),
+        samplesPerBlock, false, true, true);
+
+    loadMeasurer.reset(sampleRate, samplesPerBlock);
+
+    for (auto factor : { Oversampling_2x, Oversampling_4x })
+    {
+        // polyphase IIR half bands, integer latency so it can be reported exactly
+        using Oversampling = juce::dsp::Oversampling<float>;
+        floatOversamplers[factor] = std::make_unique<Oversampling>(spec.numChannels, size_t(factor),
+            Oversampling::filterHalfBandPolyphaseIIR, true, true);
+        floatOversamplers[factor]->initProcessing(size_t(samplesPerBlock));
+
+        doubleOversamplers[factor] = std::make_unique<juce::dsp::Oversampling<double>>(spec.numChannels, size_t(factor),
+            juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, true, true);
+        doubleOversamplers[factor]->initProcessing(size_t(samplesPerBlock));
+    }
+
+    // initialize filters with default settings, designed right here so the first block is correct
+    DesignedChain initialDesign;
+    initialDesign.chainSettings = getChainSettings(chainParameters);
+    initialDesign.sampleRate = sampleRate;
+    designChainCoefficients(initialDesign.coefficients, initialDesign.chainSettings, sampleRate);
 
-    // initialize filters with default settings
-    updateFilters();
+    activeOversampling = initialDesign.chainSettings.oversampling;
+    oversamplingLatency.store(getOversamplingLatency(activeOversampling));
+    setLatencySamples(oversamplingLatency.load());
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    updateFilters(initialDesign);
+
+    for (auto* smoother : { &smoothedPeakFreq, &smoothedPeakQuality, &smoothedLowCutFreq, &smoothedHighCutFreq })
+    {
+        smoother->reset(sampleRate, smoothingRampSeconds);
+    }
+    smoothedPeakGain.reset(sampleRate, smoothingRampSeconds);
+
+    smoothedDesign = initialDesign;
+    setSmoothingTargets(initialDesign.chainSettings, false);
+
+    // from here on the designer thread keeps the coefficients up to date
+    coefficientDesigner.prepare(sampleRate);
+    coefficientDesigner.start();
+
+    leftChannelFifo.prepare(samplesPerBlock, sampleRate);
+    rightChannelFifo.prepare(samplesPerBlock, sampleRate);
 
     osc.initialise([](float x) { return std::sin(x); });
 
+    // one helper per extra group, the audio thread takes a share itself, and never more helpers than spare cores
+    const auto numGroups = juce::jmax(floatChain.getNumGroups(), doubleChain.getNumGroups());
+    const auto spareCores = juce::jmax(0, juce::SystemStats::getNumCpus() - 2);
+    numWantedChainWorkers.store(juce::jmin(numGroups - 1, spareCores, ChainWorkerPool::maxWorkers));
+    chainWorkerPeriodMs.store(1000.0 * samplesPerBlock / sampleRate);
+    updateChainWorkers();
+
     spec.numChannels = getTotalNumOutputChannels();
     osc.prepare((spec));
     osc.setFrequency(5000);
 
-
+   #if YATBEQ_BENCHMARK_PRECISION || YATBEQ_BENCHMARK_OVERSAMPLING || YATBEQ_BENCHMARK_MULTITHREADING
+    runProcessingBenchmarks(sampleRate, samplesPerBlock);
+   #endif
 }
 
 void YATBEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    numWantedChainWorkers.store(0);
+    updateChainWorkers();
+
+    // nothing pulls designs until the next prepareToPlay(), which designs the first block itself
+    coefficientDesigner.stop();
+}
+
+void YATBEQAudioProcessor::timerCallback()
+{
+    updateChainWorkers();
+}
+
+void YATBEQAudioProcessor::updateChainWorkers()
+{
+    // prepareToPlay() isn't always called on the message thread
+    const juce::ScopedLock lock(chainWorkersLock);
+
+    const auto numWorkers = multithreading->load() > 0.5f ? numWantedChainWorkers.load() : 0;
+    const auto periodMs = chainWorkerPeriodMs.load();
+    if (numWorkers == chainWorkers.getNumWorkers() && (numWorkers == 0 || periodMs == chainWorkers.getBlockPeriodMs()))
+    {
+        return;
+    }
+
+    if (numWorkers > 0)
+        chainWorkers.start(numWorkers, periodMs);
+    else
+        chainWorkers.stop();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -133,11 +236,9 @@ bool YATBEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
     return true;
   #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any channel count works (mono, stereo, 5.1, 7.1.4, ambisonic beds...),
+    // every channel gets its own lane of the shared SIMDChain.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -154,6 +255,8 @@ bool YATBEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 void YATBEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurer, buffer.getNumSamples());
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -173,30 +276,408 @@ void YATBEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
     // Alternatively, you can process the samples with the channels
     // interleaved by keeping the same state.
 
-    // make updates
-    updateFilters();
-
-
-    // run audio
-    juce::dsp::AudioBlock<float> block(buffer);
-
     // test oscillator tone setup, measure FFT accuracy
     //buffer.clear();
+    //juce::dsp::AudioBlock<float> block(buffer);
     //juce::dsp::ProcessContextReplacing<float> stereoContext(block);
     //osc.process(stereoContext);
 
+    const bool useDouble = doublePrecision->load() > 0.5f;
+    if (useDouble != processingInDouble)
+    {
+        switchPrecision(useDouble);
+    }
+
+    if (useDouble)
+    {
+        // same sizes every block, so neither copy reallocates
+        doublePrecisionBuffer.makeCopyOf(buffer, true);
+        processFilters(doublePrecisionBuffer);
+        buffer.makeCopyOf(doublePrecisionBuffer, true);
+    }
+    else
+    {
+        processFilters(buffer);
+    }
+
+    updateAnalyzerTap(buffer);
+}
 
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+void YATBEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurer, buffer.getNumSamples());
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    processFilters(buffer);
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    updateAnalyzerTap(buffer);
+}
+
+template<typename SampleType>
+void YATBEQAudioProcessor::updateAnalyzerTap(const juce::AudioBuffer<SampleType>& buffer)
+{
+    if (analyzerSubscribers.load() == 0 || analyzerEnabled->load() < 0.5f)
+    {
+        return;
+    }
+
+    const auto decimationFactor = 1 << static_cast<int>(analyzerDecimation->load());
+
+    leftChannelFifo.update(buffer, decimationFactor);
+    rightChannelFifo.update(buffer, decimationFactor);
+}
+
+void YATBEQAudioProcessor::switchPrecision(bool toDouble)
+{
+    // the incoming chain has been sitting on whatever state it had when it last ran, resuming from that clicks.
+    // the oversamplers' half band state can't be handed across, the incoming one starts from silence
+    if (toDouble)
+    {
+        doubleChain.copyStateFrom(floatChain);
+        if (auto& oversampler = doubleOversamplers[activeOversampling])
+        {
+            oversampler->reset();
+        }
+    }
+    else
+    {
+        floatChain.copyStateFrom(doubleChain);
+        if (auto& oversampler = floatOversamplers[activeOversampling])
+        {
+            oversampler->reset();
+        }
+    }
+
+    processingInDouble = toDouble;
+}
+
+template<typename SampleType>
+void YATBEQAudioProcessor::processFilters(juce::AudioBuffer<SampleType>& buffer)
+{
+    // the pool is held for the whole block, the smoothing sub-blocks don't each take it again
+    const ChainWorkerPool::ScopedUse workers(chainWorkers);
+    auto* pool = getActiveWorkerPool(workers);
+
+    // make updates, only when the designer thread has published a new coefficient set.
+    // a set designed before the last prepareToPlay() is stale, a fresh one is already on its way
+    const bool designPulled = coefficientDesigner.pullDesign();
+    const auto& design = coefficientDesigner.getDesign();
+    const bool designValid = design.sampleRate == getSampleRate();
+    bool applyDesign = designPulled && designValid;
+
+    const auto stride = getSmoothingStrideInSamples(int(smoothingStride->load()));
+    if (stride > 0)
+    {
+        setSmoothingTargets(getChainSettings(chainParameters), true);
+    }
+    else if (designValid && (designPulled || isSmoothing()))
+    {
+        // "Smoothing" is off, the designer's sets are all there is and no parameter is read here.
+        // the smoothers follow those sets, which also ends a ramp that was running when smoothing was switched off
+        setSmoothingTargets(design.chainSettings, false);
+        applyDesign = true;
+    }
+
+    // run audio, the buffer can carry more input than output channels, only the outputs are filtered
+    auto block = juce::dsp::AudioBlock<SampleType>(buffer)
+        .getSubsetChannelBlock(0, size_t(juce::jmin(buffer.getNumChannels(), getTotalNumOutputChannels())));
+
+    if (stride > 0 && isSmoothing())
+    {
+        // while the parameters ramp, redesign every 'stride' samples with the cheap designs
+        const auto numSamples = block.getNumSamples();
+        for (size_t start = 0; start < numSamples; start += size_t(stride))
+        {
+            const auto length = juce::jmin(size_t(stride), numSamples - start);
+            updateSmoothedFilters(int(length));
+
+            auto subBlock = block.getSubBlock(start, length);
+            processChains(subBlock, length >= minPooledBlockLength ? pool : nullptr);
+        }
+
+        // the ramps finished inside this block, settle on the exact design of the final values.
+        // the designer has usually published it by now, if it hasn't the last fast design plays until it does
+        if (!isSmoothing() && designValid && design.chainSettings == smoothedDesign.chainSettings)
+        {
+            updateFilters(design);
+        }
+    }
+    else
+    {
+        if (applyDesign)
+        {
+            updateFilters(design);
+        }
+
+        processChains(block, block.getNumSamples() >= minPooledBlockLength ? pool : nullptr);
+    }
+}
+
+template<typename SampleType>
+static void processOversampledChain(juce::dsp::AudioBlock<SampleType>& block, SIMDChain<SampleType>& chain,
+    juce::dsp::Oversampling<SampleType>* oversampler, ChainWorkerPool* pool)
+{
+    using Stages = typename SIMDChain<SampleType>::Stages;
+
+    auto processStages = [&chain, pool](juce::dsp::AudioBlock<SampleType>& stagesBlock, Stages stages)
+    {
+        if (pool != nullptr)
+            chain.process(stagesBlock, stages, *pool);
+        else
+            chain.process(stagesBlock, stages);
+    };
+
+    if (oversampler == nullptr)
+    {
+        processStages(block, Stages::All);
+        return;
+    }
+
+    // the oversampler runs on the audio thread between the two parallel passes
+    processStages(block, Stages::LowCut);
+
+    auto oversampledBlock = oversampler->processSamplesUp(block);
+    processStages(oversampledBlock, Stages::PeakAndHighCut);
+    oversampler->processSamplesDown(block);
+}
+
+//==============================================================================
+#if YATBEQ_BENCHMARK_PRECISION || YATBEQ_BENCHMARK_OVERSAMPLING || YATBEQ_BENCHMARK_MULTITHREADING
+// every section active, so the benchmarks time the longest cascade. the peak and the high cut are designed
+// for the oversampled rate, like designChainCoefficients() does for the "Oversampling" factors
+static DesignedChain makeBenchmarkDesign(double sampleRate, int oversamplingFactor = 1)
+{
+    DesignedChain design;
+
+    auto& settings = design.chainSettings;
+    settings.lowCutFreq = 80.f;
+    settings.lowCutSlope = Slope_48;
+    settings.highCutFreq = 12000.f;
+    settings.highCutSlope = Slope_48;
+    settings.peakFreq = 1000.f;
+    settings.peakGainInDecibels = 6.f;
+    settings.peakQuality = 1.f;
+
+    design.sampleRate = sampleRate;
+    designChainCoefficients(design.coefficients, settings, sampleRate);
+    designPeakFilter(design.coefficients.peak, settings, sampleRate * oversamplingFactor);
+    designHighCutFilter(design.coefficients.highCut, settings, sampleRate * oversamplingFactor);
+
+    return design;
+}
+
+// noise a good way below full scale. every timed block starts with a copy of it, processing the same buffer
+// in place over and over would pile up the peak's boost until it overflows
+static juce::AudioBuffer<float> makeBenchmarkNoise(int numChannels, int numSamples)
+{
+    juce::AudioBuffer<float> noise(numChannels, numSamples);
+
+    juce::Random random(1);
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            noise.setSample(channel, i, 0.25f * (2.f * random.nextFloat() - 1.f));
+        }
+    }
+
+    return noise;
+}
+
+#endif
+
+#if YATBEQ_BENCHMARK_PRECISION
+// one stereo block through the float chain, the double chain, and the double chain as "Double Precision" runs it
+// for a float host, with the conversion into and out of the double buffer
+static void benchmarkPrecision(double sampleRate, int samplesPerBlock)
+{
+    constexpr int numBlocks = 2000;
+
+    const juce::dsp::ProcessSpec spec{ sampleRate, juce::uint32(samplesPerBlock), 2 };
+    const auto design = makeBenchmarkDesign(sampleRate);
+
+    SIMDChain<float> floatChain;
+    SIMDChain<double> doubleChain;
+    floatChain.prepare(spec);
+    doubleChain.prepare(spec);
+    floatChain.setCoefficients(design);
+    doubleChain.setCoefficients(design);
+
+    const auto noise = makeBenchmarkNoise(2, samplesPerBlock);
+    juce::AudioBuffer<float> floatBuffer(2, samplesPerBlock);
+    juce::AudioBuffer<double> doubleBuffer(2, samplesPerBlock);
+
+    const auto floatMs = averageMilliseconds(numBlocks, [&]
+    {
+        floatBuffer.makeCopyOf(noise, true);
+        juce::dsp::AudioBlock<float> block(floatBuffer);
+        floatChain.process(block);
+    });
+
+    const auto doubleMs = averageMilliseconds(numBlocks, [&]
+    {
+        doubleBuffer.makeCopyOf(noise, true);
+        juce::dsp::AudioBlock<double> block(doubleBuffer);
+        doubleChain.process(block);
+    });
+
+    const auto convertedDoubleMs = averageMilliseconds(numBlocks, [&]
+    {
+        floatBuffer.makeCopyOf(noise, true);
+        doubleBuffer.makeCopyOf(floatBuffer, true);
+        juce::dsp::AudioBlock<double> block(doubleBuffer);
+        doubleChain.process(block);
+        floatBuffer.makeCopyOf(doubleBuffer, true);
+    });
+
+    const auto blockMs = 1000.0 * samplesPerBlock / sampleRate;
+
+    juce::Logger::writeToLog(juce::String::formatted(
+        "precision, %d samples at %.0f Hz (%.3f ms): float %.4f ms, double %.4f ms, double from a float host %.4f ms",
+        samplesPerBlock, sampleRate, blockMs, floatMs, doubleMs, convertedDoubleMs));
+}
+#endif
+
+#if YATBEQ_BENCHMARK_OVERSAMPLING
+// one stereo block through the float chain the way processChains() runs it at each factor: the low cut
+// at the host rate, the peak and the high cut between the polyphase IIR up and down sampling. 8x isn't
+// an "Oversampling" choice, it's there to show where the cost is heading
+static void benchmarkOversampling(double sampleRate, int samplesPerBlock)
+{
+    constexpr int numBlocks = 1000;
+
+    const auto noise = makeBenchmarkNoise(2, samplesPerBlock);
+    juce::AudioBuffer<float> buffer(2, samplesPerBlock);
+    juce::String results;
+    double baseMs = 0;
+
+    for (int shift = 0; shift <= 3; ++shift)
+    {
+        const auto factor = 1 << shift;
+
+        SIMDChain<float> chain;
+        chain.prepare({ sampleRate * factor, juce::uint32(samplesPerBlock * factor), 2 });
+        chain.setCoefficients(makeBenchmarkDesign(sampleRate, factor));
+
+        std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+        if (shift > 0)
+        {
+            oversampler = std::make_unique<juce::dsp::Oversampling<float>>(2, size_t(shift),
+                juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+            oversampler->initProcessing(size_t(samplesPerBlock));
+        }
+
+        const auto ms = averageMilliseconds(numBlocks, [&]
+        {
+            buffer.makeCopyOf(noise, true);
+            juce::dsp::AudioBlock<float> block(buffer);
+            processOversampledChain(block, chain, oversampler.get(), nullptr);
+        });
+
+        if (shift == 0)
+        {
+            baseMs = ms;
+        }
+
+        results << ", " << factor << "x " << juce::String(ms, 4) << " ms (" << juce::String(ms / baseMs, 2) << "x)";
+    }
+
+    juce::Logger::writeToLog("oversampling, " + juce::String(samplesPerBlock) + " samples at "
+        + juce::String(sampleRate, 0) + " Hz" + results);
+}
+#endif
+
+#if YATBEQ_BENCHMARK_MULTITHREADING
+// one block of 2 to 64 channels through the float chain on the audio thread alone, and spread over as many
+// workers as prepareToPlay() would start for that bus
+static void benchmarkMultithreading(double sampleRate, int samplesPerBlock)
+{
+    constexpr int numBlocks = 500;
+
+    const auto design = makeBenchmarkDesign(sampleRate);
+    const auto spareCores = juce::jmax(0, juce::SystemStats::getNumCpus() - 2);
+
+    for (int numChannels = 2; numChannels <= 64; numChannels *= 2)
+    {
+        SIMDChain<float> chain;
+        chain.prepare({ sampleRate, juce::uint32(samplesPerBlock), juce::uint32(numChannels) });
+        chain.setCoefficients(design);
+
+        const auto noise = makeBenchmarkNoise(numChannels, samplesPerBlock);
+        juce::AudioBuffer<float> buffer(numChannels, samplesPerBlock);
+
+        auto timeBlocks = [&](ChainWorkerPool* pool)
+        {
+            return averageMilliseconds(numBlocks, [&]
+            {
+                buffer.makeCopyOf(noise, true);
+                juce::dsp::AudioBlock<float> block(buffer);
+
+                if (pool != nullptr)
+                    chain.process(block, SIMDChain<float>::Stages::All, *pool);
+                else
+                    chain.process(block);
+            });
+        };
+
+        const auto singleMs = timeBlocks(nullptr);
+
+        const auto numWorkers = juce::jmin(chain.getNumGroups() - 1, spareCores, ChainWorkerPool::maxWorkers);
+        ChainWorkerPool pool;
+        pool.start(numWorkers, 1000.0 * samplesPerBlock / sampleRate);
+
+        double pooledMs = 0;
+        {
+            const ChainWorkerPool::ScopedUse workers(pool);
+            pooledMs = timeBlocks(&pool);
+        }
+
+        pool.stop();
+
+        juce::Logger::writeToLog(juce::String::formatted(
+            "multithreading, %d channels, %d samples: audio thread alone %.4f ms, with %d workers %.4f ms (%.2fx)",
+            numChannels, samplesPerBlock, singleMs, numWorkers, pooledMs, singleMs / pooledMs));
+    }
+}
+#endif
+
+static void runProcessingBenchmarks(double sampleRate, int samplesPerBlock)
+{
+   #if YATBEQ_BENCHMARK_PRECISION
+    benchmarkPrecision(sampleRate, samplesPerBlock);
+   #endif
+   #if YATBEQ_BENCHMARK_OVERSAMPLING
+    benchmarkOversampling(sampleRate, samplesPerBlock);
+   #endif
+   #if YATBEQ_BENCHMARK_MULTITHREADING
+    benchmarkMultithreading(sampleRate, samplesPerBlock);
+   #endif
+}
+#endif
+
+
+ChainWorkerPool* YATBEQAudioProcessor::getActiveWorkerPool(const ChainWorkerPool::ScopedUse& workers)
+{
+    // the parameter is checked here too, the workers only stop at the next timer tick
+    if (multithreading->load() > 0.5f && workers.isActive())
+    {
+        return &chainWorkers;
+    }
+
+    return nullptr;
+}
+
+void YATBEQAudioProcessor::processChains(juce::dsp::AudioBlock<float>& block, ChainWorkerPool* pool)
+{
+    processOversampledChain(block, floatChain, floatOversamplers[activeOversampling].get(), pool);
+}
+
+void YATBEQAudioProcessor::processChains(juce::dsp::AudioBlock<double>& block, ChainWorkerPool* pool)
+{
+    processOversampledChain(block, doubleChain, doubleOversamplers[activeOversampling].get(), pool);
 }
 
 //==============================================================================
@@ -231,7 +712,9 @@ void YATBEQAudioProcessor::setStateInformation (const void* data, int sizeInByte
     if (tree.isValid())
     {
         apvts.replaceState(tree);
-        updateFilters();
+
+        // the audio thread picks the new state up as soon as it has been designed
+        coefficientDesigner.requestDesign();
     }
 }
 
@@ -292,55 +775,693 @@ juce::AudioProcessorValueTreeState::ParameterLayout YATBEQAudioProcessor::create
     rtn.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed", "Peak Bypassed", false));
     rtn.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled", "Analyzer Enabled", true));
 
+    // the index is decoded by getSmoothingStrideInSamples()
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Smoothing", "Smoothing",
+        juce::StringArray{ "Off", "32 Samples", "16 Samples" }, 0));
+
+    rtn.add(std::make_unique<juce::AudioParameterBool>("Double Precision", "Double Precision", false));
+
+    // the index is an Oversampling_Factor
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling",
+        juce::StringArray{ "1x", "2x", "4x" }, 0));
+
+    rtn.add(std::make_unique<juce::AudioParameterBool>("Multithreading", "Multithreading", false));
+
+    // the index is decoded in updateAnalyzerTap(), the low resolution views don't need the full rate
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Decimation", "Analyzer Decimation",
+        juce::StringArray{ "Off", "2:1", "4:1" }, 0));
+
+    // the index is an Analyzer_Mode
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Mode", "Analyzer Mode",
+        juce::StringArray{ "Left/Right", "Mid/Side" }, 0));
+
+    // the STFT hop is half or a quarter of the FFT size
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Overlap", "Analyzer Overlap",
+        juce::StringArray{ "50%", "75%" }, 0));
+
+    // the index is added to order2048, the window order matches PathProducer::updateAnalysisSettings()
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer FFT Size", "Analyzer FFT Size",
+        juce::StringArray{ "2048", "4096", "8192" }, 0));
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Window", "Analyzer Window",
+        juce::StringArray{ "Blackman-Harris", "Hann", "Hamming", "Blackman", "Flat Top", "Rectangular" }, 0));
+
+    // display smoothing, decoded in PathProducer::updateAnalysisSettings()
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Averaging", "Analyzer Averaging",
+        juce::StringArray{ "Off", "Fast", "Slow" }, 0));
+    rtn.add(std::make_unique<juce::AudioParameterBool>("Analyzer Peak Hold", "Analyzer Peak Hold", false));
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Smoothing", "Analyzer Smoothing",
+        juce::StringArray{ "Off", "1/3 Octave", "1/6 Octave", "1/12 Octave" }, 0));
+    rtn.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Renderer", "Analyzer Renderer",
+        juce::StringArray{ "Path", "Bitmap", "Filled Bitmap", "Spectrogram" }, 0));
+
     return rtn;
 }
 
-void YATBEQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
+void YATBEQAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    coefficientDesigner.requestDesign();
+}
+
+void YATBEQAudioProcessor::updateFilters(const DesignedChain& design)
+{
+    // both precisions stay current, so switching "Double Precision" never plays a stale design
+    floatChain.setCoefficients(design);
+    doubleChain.setCoefficients(design);
+
+    // the coefficients and the rate they run at have to switch together
+    const auto factor = design.chainSettings.oversampling;
+    if (factor != activeOversampling)
+    {
+        activeOversampling = factor;
+
+        // the peak and high cut state was built up at the old rate, played on at the new one it rings out as a click
+        floatChain.reset(SIMDChain<float>::Stages::PeakAndHighCut);
+        doubleChain.reset(SIMDChain<double>::Stages::PeakAndHighCut);
+
+        if (auto& oversampler = floatOversamplers[factor])
+        {
+            oversampler->reset();
+        }
+        if (auto& oversampler = doubleOversamplers[factor])
+        {
+            oversampler->reset();
+        }
+
+        oversamplingLatency.store(getOversamplingLatency(factor));
+        triggerAsyncUpdate();
+    }
+}
+
+int YATBEQAudioProcessor::getOversamplingLatency(Oversampling_Factor factor) const
+{
+    if (auto& oversampler = floatOversamplers[factor])
+    {
+        return juce::roundToInt(oversampler->getLatencyInSamples());
+    }
+
+    return 0;
+}
+
+void YATBEQAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(oversamplingLatency.load());
+}
+
+//==============================================================================
+//
+// SIMDChain:: members
+// 
+//==============================================================================
+template<typename SampleType>
+void SIMDChain<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    const auto numGroups = (int(spec.numChannels) + lanes - 1) / lanes;
+
+    groups.resize(size_t(numGroups));
+
+    // pass-through until the first setCoefficients()
+    cascadeKernels.fill(getCascadeKernel(0, 0, 0));
+
+    reset();
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::reset()
+{
+    const auto zero = Vec::expand(SampleType(0));
+
+    for (auto& group : groups)
+    {
+        group.s1.fill(zero);
+        group.s2.fill(zero);
+    }
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::reset(Stages stages)
+{
+    const auto first = stages == Stages::PeakAndHighCut ? peakSection : firstLowCutSection;
+    const auto last = stages == Stages::LowCut ? peakSection : numSections;
+    const auto zero = Vec::expand(SampleType(0));
+
+    for (auto& group : groups)
+    {
+        std::fill(group.s1.begin() + first, group.s1.begin() + last, zero);
+        std::fill(group.s2.begin() + first, group.s2.begin() + last, zero);
+    }
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::setCoefficients(const DesignedChain& design)
+{
+    const auto& chainSettings = design.chainSettings;
+    const auto& coefficients = design.coefficients;
+
+    auto setSection = [this](int sectionIndex, const BiquadCoefficients& c)
+    {
+        auto& section = sections[sectionIndex];
+        section.b0 = Vec::expand(static_cast<SampleType>(c.b0));
+        section.b1 = Vec::expand(static_cast<SampleType>(c.b1));
+        section.b2 = Vec::expand(static_cast<SampleType>(c.b2));
+        section.a1 = Vec::expand(static_cast<SampleType>(c.a1));
+        section.a2 = Vec::expand(static_cast<SampleType>(c.a2));
+    };
+
+    // Slope_12 is stage 0 only, Slope_48 is stages 0 to 3
+    const int numLowCutSections = chainSettings.lowCutBypassed ? 0 : chainSettings.lowCutSlope + 1;
+    const int numPeakSections = chainSettings.peakBypassed ? 0 : 1;
+    const int numHighCutSections = chainSettings.highCutBypassed ? 0 : chainSettings.highCutSlope + 1;
+
+    for (int i = 0; i < numLowCutSections; ++i)
+    {
+        setSection(firstLowCutSection + i, coefficients.lowCut[i]);
+    }
+
+    if (numPeakSections > 0)
+    {
+        setSection(peakSection, coefficients.peak);
+    }
+
+    for (int i = 0; i < numHighCutSections; ++i)
+    {
+        setSection(firstHighCutSection + i, coefficients.highCut[i]);
+    }
+
+    cascadeKernels[size_t(Stages::All)] = getCascadeKernel(numLowCutSections, numPeakSections, numHighCutSections);
+    cascadeKernels[size_t(Stages::LowCut)] = getCascadeKernel(numLowCutSections, 0, 0);
+    cascadeKernels[size_t(Stages::PeakAndHighCut)] = getCascadeKernel(0, numPeakSections, numHighCutSections);
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::process(juce::dsp::AudioBlock<SampleType>& block, Stages stages)
+{
+    jassert(int(block.getNumChannels()) <= getNumGroups() * lanes);
+
+    for (int group = 0; group < getNumGroups(); ++group)
+    {
+        processGroup(block, stages, group);
+    }
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::process(juce::dsp::AudioBlock<SampleType>& block, Stages stages, ChainWorkerPool& pool)
+{
+    jassert(int(block.getNumChannels()) <= getNumGroups() * lanes);
+
+    struct Context
+    {
+        SIMDChain& chain;
+        juce::dsp::AudioBlock<SampleType>& block;
+        Stages stages;
+    };
+
+    Context context{ *this, block, stages };
+
+    pool.run([](void* c, int group)
+        {
+            auto& context = *static_cast<Context*>(c);
+            context.chain.processGroup(context.block, context.stages, group);
+        },
+        &context, getNumGroups());
+}
+
+template<typename SampleType>
+void SIMDChain<SampleType>::processGroup(juce::dsp::AudioBlock<SampleType>& block, Stages stages, int group)
 {
-    auto peakCoefficients = makeThisPeakFilter(chainSettings, getSampleRate());
+    const auto cascadeKernel = cascadeKernels[size_t(stages)];
 
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    const auto numChannels = int(block.getNumChannels());
+    const auto numSamples = block.getNumSamples();
+
+    const auto firstChannel = group * lanes;
+    const auto channelsInGroup = juce::jmin(lanes, numChannels - firstChannel);
+
+    if (channelsInGroup <= 0)
+    {
+        return;
+    }
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    SampleType* channels[lanes] = {};
+    for (int lane = 0; lane < channelsInGroup; ++lane)
+    {
+        channels[lane] = block.getChannelPointer(size_t(firstChannel + lane));
+    }
+
+    auto& state = groups[size_t(group)];
+
+    Tile tile;
+
+    // unused lanes run on silence
+    alignas(Vec) SampleType frame[lanes] = {};
+
+    for (size_t start = 0; start < numSamples; start += tileSize)
+    {
+        const auto tileLength = juce::jmin(tileSize, numSamples - start);
+
+        // interleave
+        for (size_t i = 0; i < tileLength; ++i)
+        {
+            for (int lane = 0; lane < channelsInGroup; ++lane)
+            {
+                frame[lane] = channels[lane][start + i];
+            }
+            tile[i] = Vec::fromRawArray(frame);
+        }
+
+        (this->*cascadeKernel)(state, tile, tileLength);
+
+        // de-interleave
+        for (size_t i = 0; i < tileLength; ++i)
+        {
+            tile[i].copyToRawArray(frame);
+            for (int lane = 0; lane < channelsInGroup; ++lane)
+            {
+                channels[lane][start + i] = frame[lane];
+            }
+        }
+    }
 }
 
-void YATBEQAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
+template<typename SampleType>
+template<int NumLowCutSections, int NumPeakSections, int NumHighCutSections>
+void SIMDChain<SampleType>::processCascade(GroupState& state, Tile& tile, size_t numSamples) const
 {
+    constexpr int numActiveSections = NumLowCutSections + NumPeakSections + NumHighCutSections;
+
+    if constexpr (numActiveSections > 0)
+    {
+        // the section slots this kernel runs, in processing order
+        constexpr auto activeSections = []
+        {
+            std::array<int, numActiveSections> rtn{};
+            int n = 0;
+            for (int i = 0; i < NumLowCutSections; ++i)
+                rtn[n++] = firstLowCutSection + i;
+            for (int i = 0; i < NumPeakSections; ++i)
+                rtn[n++] = peakSection;
+            for (int i = 0; i < NumHighCutSections; ++i)
+                rtn[n++] = firstHighCutSection + i;
+            return rtn;
+        }();
+
+        // pull the coefficients and state into locals for the length of the tile
+        std::array<Section, numActiveSections> c;
+        std::array<Vec, numActiveSections> s1, s2;
+
+        for (int k = 0; k < numActiveSections; ++k)
+        {
+            c[k] = sections[activeSections[k]];
+            s1[k] = state.s1[activeSections[k]];
+            s2[k] = state.s2[activeSections[k]];
+        }
+
+        // every section on one sample before moving to the next
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto x = tile[i];
+
+            [&]<int... K>(std::integer_sequence<int, K...>)
+            {
+                ((x = processSample(c[K], s1[K], s2[K], x)), ...);
+            }(std::make_integer_sequence<int, numActiveSections>());
+
+            tile[i] = x;
+        }
+
+        for (int k = 0; k < numActiveSections; ++k)
+        {
+            state.s1[activeSections[k]] = s1[k];
+            state.s2[activeSections[k]] = s2[k];
+        }
+    }
+    else
+    {
+        juce::ignoreUnused(state, tile, numSamples);
+    }
+}
 
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+template<typename SampleType>
+typename SIMDChain<SampleType>::CascadeKernel SIMDChain<SampleType>::getCascadeKernel(int numLowCutSections, int numPeakSections, int numHighCutSections)
+{
+    constexpr int numCutCounts = MaxCutSections + 1;
+    constexpr int numPeakCounts = 2;
 
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+    // kernels[low][peak][high] flattened, every combination is instantiated once
+    static constexpr auto kernels = []<int... Indices>(std::integer_sequence<int, Indices...>)
+    {
+        return std::array<CascadeKernel, sizeof...(Indices)>
+        {
+            &SIMDChain::template processCascade<Indices / (numPeakCounts * numCutCounts),
+                                       (Indices / numCutCounts) % numPeakCounts,
+                                       Indices % numCutCounts>...
+        };
+    }(std::make_integer_sequence<int, numCutCounts * numPeakCounts * numCutCounts>());
+
+    jassert(juce::isPositiveAndBelow(numLowCutSections, numCutCounts));
+    jassert(juce::isPositiveAndBelow(numPeakSections, numPeakCounts));
+    jassert(juce::isPositiveAndBelow(numHighCutSections, numCutCounts));
+
+    return kernels[size_t((numLowCutSections * numPeakCounts + numPeakSections) * numCutCounts + numHighCutSections)];
+}
 
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+template struct SIMDChain<float>;
+template struct SIMDChain<double>;
 
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+int YATBEQAudioProcessor::getSmoothingStrideInSamples(int choiceIndex)
+{
+    switch (choiceIndex)
+    {
+    case 1: return 32;
+    case 2: return 16;
+    default: return 0;
+    }
 }
 
-void YATBEQAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
+void YATBEQAudioProcessor::setSmoothingTargets(const ChainSettings& chainSettings, bool smoothingEnabled)
 {
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    // the slopes and bypasses switch immediately, only the continuous values ramp
+    smoothedDesign.chainSettings = chainSettings;
+    smoothedDesign.sampleRate = getSampleRate();
 
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    if (smoothingEnabled)
+    {
+        smoothedPeakFreq.setTargetValue(chainSettings.peakFreq);
+        smoothedPeakGain.setTargetValue(chainSettings.peakGainInDecibels);
+        smoothedPeakQuality.setTargetValue(chainSettings.peakQuality);
+        smoothedLowCutFreq.setTargetValue(chainSettings.lowCutFreq);
+        smoothedHighCutFreq.setTargetValue(chainSettings.highCutFreq);
+    }
+    else
+    {
+        // keep tracking, so switching smoothing on never starts a ramp from a stale value
+        smoothedPeakFreq.setCurrentAndTargetValue(chainSettings.peakFreq);
+        smoothedPeakGain.setCurrentAndTargetValue(chainSettings.peakGainInDecibels);
+        smoothedPeakQuality.setCurrentAndTargetValue(chainSettings.peakQuality);
+        smoothedLowCutFreq.setCurrentAndTargetValue(chainSettings.lowCutFreq);
+        smoothedHighCutFreq.setCurrentAndTargetValue(chainSettings.highCutFreq);
+    }
+}
+
+bool YATBEQAudioProcessor::isSmoothing() const
+{
+    return smoothedPeakFreq.isSmoothing() || smoothedPeakGain.isSmoothing() || smoothedPeakQuality.isSmoothing()
+        || smoothedLowCutFreq.isSmoothing() || smoothedHighCutFreq.isSmoothing();
+}
+
+void YATBEQAudioProcessor::updateSmoothedFilters(int numSamples)
+{
+    auto& chainSettings = smoothedDesign.chainSettings;
+    chainSettings.peakFreq = smoothedPeakFreq.skip(numSamples);
+    chainSettings.peakGainInDecibels = smoothedPeakGain.skip(numSamples);
+    chainSettings.peakQuality = smoothedPeakQuality.skip(numSamples);
+    chainSettings.lowCutFreq = smoothedLowCutFreq.skip(numSamples);
+    chainSettings.highCutFreq = smoothedHighCutFreq.skip(numSamples);
+
+    designChainCoefficientsFast(smoothedDesign.coefficients, chainSettings, smoothedDesign.sampleRate);
+    updateFilters(smoothedDesign);
+}
+
+//==============================================================================
+//
+// CoefficientDesigner:: members
+// 
+//==============================================================================
+CoefficientDesigner::CoefficientDesigner(const ChainParameters& params) :
+    juce::Thread("YATBEQ Coefficient Designer"),
+    chainParameters(params)
+{
+}
 
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+CoefficientDesigner::~CoefficientDesigner()
+{
+    stop();
+}
+
+void CoefficientDesigner::prepare(double sampleRate)
+{
+    designSampleRate.store(sampleRate);
+    requestDesign();
+}
 
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+void CoefficientDesigner::start()
+{
+    if (!isThreadRunning())
+    {
+        startThread();
+    }
 }
 
-void YATBEQAudioProcessor::updateFilters()
+void CoefficientDesigner::stop()
 {
-    auto chainSettings = getTreeStateChainSettings(apvts);
-    updatePeakFilter(chainSettings);
-    updateLowCutFilters(chainSettings);
-    updateHighCutFilters(chainSettings);
+    signalThreadShouldExit();
+    wake();
+    stopThread(1000);
+}
+
+void CoefficientDesigner::requestDesign()
+{
+    designPending.store(true);
+
+    // a futex or WaitOnAddress wake, only when the designer went to sleep
+    if (parked.load())
+    {
+        wake();
+    }
+}
+
+void CoefficientDesigner::wake()
+{
+    wakeGeneration.fetch_add(1);
+    wakeGeneration.notify_all();
+}
+
+void CoefficientDesigner::run()
+{
+    // polled rather than notified: notify() signals a WaitableEvent, which locks a mutex this thread also holds.
+    // the atomic wait it parks on once the parameters have settled has no such lock
+    int emptyPolls = 0;
+
+    while (!threadShouldExit())
+    {
+        // clearing the flag before reading the parameters means a change that lands
+        // mid-design sets it again and gets its own pass
+        while (!threadShouldExit() && designPending.exchange(false))
+        {
+            emptyPolls = 0;
+
+            const auto sampleRate = designSampleRate.load();
+            if (sampleRate <= 0)
+            {
+                continue;
+            }
+
+            auto& design = designs.getWriteBuffer();
+            design.chainSettings = getChainSettings(chainParameters);
+            design.sampleRate = sampleRate;
+            designChainCoefficients(design.coefficients, design.chainSettings, sampleRate);
+
+            designs.publish();
+        }
+
+        if (++emptyPolls < pollsBeforePark)
+        {
+            wait(pollIntervalMs);
+            continue;
+        }
+
+        // counted as parked before the last look at the flag, see requestDesign()
+        const auto generation = wakeGeneration.load();
+        parked.store(true);
+
+        if (!designPending.load() && !threadShouldExit())
+        {
+            wakeGeneration.wait(generation);
+        }
+
+        parked.store(false);
+        emptyPolls = 0;
+    }
+}
+
+//==============================================================================
+//
+// ChainWorkerPool:: members
+// 
+//==============================================================================
+static forcedinline void spinPause() noexcept
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #else
+    std::this_thread::yield();
+   #endif
+}
+
+ChainWorkerPool::~ChainWorkerPool()
+{
+    stop();
+}
+
+void ChainWorkerPool::start(int numWorkers, double blockPeriodMs)
+{
+    stop();
+
+    // the audio thread waits on the slices a worker has claimed, so a worker has to be scheduled like one
+    const auto options = juce::Thread::RealtimeOptions{}.withPeriodMs(blockPeriodMs);
+    periodMs = blockPeriodMs;
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back(std::make_unique<Worker>(*this));
+        if (!workers.back()->startRealtimeThread(options))
+        {
+            workers.back()->startThread(juce::Thread::Priority::highest);
+        }
+    }
+
+    active.store(true);
+}
+
+void ChainWorkerPool::stop()
+{
+    // from here on no new block picks the pool up, a block that already has it finishes first
+    active.store(false);
+    while (inUse.load())
+    {
+        std::this_thread::yield();
+    }
+
+    for (auto& worker : workers)
+    {
+        worker->signalThreadShouldExit();
+    }
+
+    wakeParkedWorkers();
+
+    for (auto& worker : workers)
+    {
+        worker->stopThread(1000);
+    }
+
+    workers.clear();
+}
+
+void ChainWorkerPool::wakeParkedWorkers()
+{
+    wakeGeneration.fetch_add(1);
+    wakeGeneration.notify_all();
+}
+
+void ChainWorkerPool::run(Job job, void* context, int numSlices)
+{
+    jassert(numSlices < (1 << 16));
+
+    if (workers.empty() || numSlices <= 1)
+    {
+        for (int slice = 0; slice < numSlices; ++slice)
+        {
+            job(context, slice);
+        }
+        return;
+    }
+
+    currentJob = job;
+    currentContext = context;
+    completedSlices.store(0, std::memory_order_relaxed);
+
+    const auto generation = (work.load(std::memory_order_relaxed) >> 32) + 1;
+    work.store((generation << 32) | (juce::uint64(numSlices) << 16));
+
+    // a futex or WaitOnAddress wake, only when a worker went to sleep since the last block
+    if (numParked.load() > 0)
+    {
+        wakeParkedWorkers();
+    }
+
+    runPendingSlices();
+
+    // whatever is still outstanding was claimed by a worker that is running it right now
+    while (completedSlices.load(std::memory_order_acquire) < numSlices)
+    {
+        spinPause();
+    }
+}
+
+bool ChainWorkerPool::runPendingSlices()
+{
+    bool ranSlice = false;
+    auto current = work.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto nextSlice = int(current & 0xffff);
+        const auto numSlices = int((current >> 16) & 0xffff);
+
+        if (nextSlice >= numSlices)
+        {
+            return ranSlice;
+        }
+
+        if (work.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            // the audio thread can't publish the next job before this slice is counted
+            currentJob(currentContext, nextSlice);
+            completedSlices.fetch_add(1, std::memory_order_release);
+
+            ranSlice = true;
+            current = work.load(std::memory_order_acquire);
+        }
+    }
+}
+
+ChainWorkerPool::Worker::Worker(ChainWorkerPool& owner) :
+    juce::Thread("YATBEQ Chain Worker"),
+    pool(owner)
+{
+}
+
+void ChainWorkerPool::Worker::run()
+{
+    // spin while blocks are coming in, back off to yield() and then park until the next job once they stop
+    constexpr int spinsBeforeYield = 2000;
+    constexpr int yieldsBeforePark = 20000;
+
+    int idleCount = 0;
+
+    while (!threadShouldExit())
+    {
+        if (pool.runPendingSlices())
+        {
+            idleCount = 0;
+        }
+        else if (idleCount < spinsBeforeYield)
+        {
+            ++idleCount;
+            spinPause();
+        }
+        else if (idleCount < spinsBeforeYield + yieldsBeforePark)
+        {
+            ++idleCount;
+            std::this_thread::yield();
+        }
+        else
+        {
+            // counted as parked before the last look at the work word, see ChainWorkerPool::run()
+            const auto generation = pool.wakeGeneration.load();
+            pool.numParked.fetch_add(1);
+
+            const auto current = pool.work.load();
+            const auto hasPendingSlices = int(current & 0xffff) < int((current >> 16) & 0xffff);
+
+            if (!hasPendingSlices && !threadShouldExit())
+            {
+                pool.wakeGeneration.wait(generation);
+            }
+
+            pool.numParked.fetch_sub(1);
+            idleCount = 0;
+        }
+    }
 }
 
 //==============================================================================
@@ -369,10 +1490,273 @@ ChainSettings getTreeStateChainSettings(juce::AudioProcessorValueTreeState& apvt
     rtn.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load() > 0.5f;
     rtn.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
 
+    rtn.oversampling = static_cast<Oversampling_Factor>(apvts.getRawParameterValue("Oversampling")->load());
+
+    return rtn;
+}
+
+void ChainParameters::attachTo(juce::AudioProcessorValueTreeState& apvts)
+{
+    lowCutFreq = apvts.getRawParameterValue("LowCut Freq");
+    highCutFreq = apvts.getRawParameterValue("HighCut Freq");
+    peakFreq = apvts.getRawParameterValue("Peak Freq");
+    peakGainInDecibels = apvts.getRawParameterValue("Peak Gain");
+    peakQuality = apvts.getRawParameterValue("Peak Quality");
+    lowCutSlope = apvts.getRawParameterValue("LowCut Slope");
+    highCutSlope = apvts.getRawParameterValue("HighCut Slope");
+    lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed");
+    highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed");
+    peakBypassed = apvts.getRawParameterValue("Peak Bypassed");
+    oversampling = apvts.getRawParameterValue("Oversampling");
+}
+
+ChainSettings getChainSettings(const ChainParameters& chainParameters)
+{
+    ChainSettings rtn;
+
+    rtn.lowCutFreq = chainParameters.lowCutFreq->load();
+    rtn.highCutFreq = chainParameters.highCutFreq->load();
+    rtn.peakFreq = chainParameters.peakFreq->load();
+    rtn.peakGainInDecibels = chainParameters.peakGainInDecibels->load();
+    rtn.peakQuality = chainParameters.peakQuality->load();
+
+    rtn.lowCutSlope = static_cast<Cut_Slope>(chainParameters.lowCutSlope->load());
+    rtn.highCutSlope = static_cast<Cut_Slope>(chainParameters.highCutSlope->load());
+
+    rtn.lowCutBypassed = chainParameters.lowCutBypassed->load() > 0.5f;
+    rtn.highCutBypassed = chainParameters.highCutBypassed->load() > 0.5f;
+    rtn.peakBypassed = chainParameters.peakBypassed->load() > 0.5f;
+
+    rtn.oversampling = static_cast<Oversampling_Factor>(chainParameters.oversampling->load());
+
+    return rtn;
+}
+
+//==============================================================================
+//
+// allocation free filter design
+// 
+// these produce the same sections as juce::dsp::IIR::Coefficients<float>::makePeakFilter(),
+// makeHighPass() and makeLowPass() and the FilterDesign<float> Butterworth methods,
+// but write into preallocated storage instead of new ref-counted objects
+//==============================================================================
+static BiquadCoefficients makeNormalisedBiquad(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    const auto a0Inv = 1.0 / a0;
+
+    BiquadCoefficients rtn;
+    rtn.b0 = b0 * a0Inv;
+    rtn.b1 = b1 * a0Inv;
+    rtn.b2 = b2 * a0Inv;
+    rtn.a1 = a1 * a0Inv;
+    rtn.a2 = a2 * a0Inv;
     return rtn;
 }
 
-void updateCoefficients(MyCoefficients& old, const MyCoefficients& replacements)
+// the trig used by the designs, std:: for the exact designs the designer thread publishes,
+// juce::dsp::FastMathApproximations for the per-stride designs made while parameters ramp
+struct PreciseDesignMath
+{
+    static double sin(double x) { return std::sin(x); }
+    static double cos(double x) { return std::cos(x); }
+    static double tan(double x) { return std::tan(x); }
+    static double exp(double x) { return std::exp(x); }
+};
+
+struct FastDesignMath
+{
+    // valid for -pi..pi, -pi..pi, -pi/2..pi/2 and -6..4, which covers every parameter range below
+    static double sin(double x) { return juce::dsp::FastMathApproximations::sin(x); }
+    static double cos(double x) { return juce::dsp::FastMathApproximations::cos(x); }
+    static double tan(double x) { return juce::dsp::FastMathApproximations::tan(x); }
+    static double exp(double x) { return juce::dsp::FastMathApproximations::exp(x); }
+};
+
+// 1/Q of Butterworth section 'index' of an even order cascade
+template<typename DesignMath>
+static double getButterworthInverseQuality(int index, int order)
+{
+    return 2.0 * DesignMath::cos((2.0 * index + 1.0) * juce::MathConstants<double>::pi / (order * 2.0));
+}
+
+template<typename DesignMath>
+static void designPeak(BiquadCoefficients& peak, const ChainSettings& chainSettings, double sampleRate)
+{
+    // sqrt(decibelsToGain(dB)) == 10^(dB / 40) == e^(dB * ln(10) / 40)
+    constexpr double ln10 = 2.302585092994046;
+    const auto A = DesignMath::exp(chainSettings.peakGainInDecibels * ln10 / 40.0);
+    const auto omega = juce::MathConstants<double>::twoPi * juce::jmax(double(chainSettings.peakFreq), 2.0) / sampleRate;
+    const auto alpha = DesignMath::sin(omega) / (chainSettings.peakQuality * 2.0);
+    const auto c2 = -2.0 * DesignMath::cos(omega);
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+
+    peak = makeNormalisedBiquad(1.0 + alphaTimesA, c2, 1.0 - alphaTimesA,
+        1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
+
+template<typename DesignMath>
+static void designLowCut(CutCoefficients& lowCut, const ChainSettings& chainSettings, double sampleRate)
+{
+    jassert(chainSettings.lowCutFreq > 0 && chainSettings.lowCutFreq <= sampleRate * 0.5);
+
+    const int order = 2 * (chainSettings.lowCutSlope + 1);
+    const auto n = DesignMath::tan(juce::MathConstants<double>::pi * chainSettings.lowCutFreq / sampleRate);
+    const auto nSquared = n * n;
+
+    for (int i = 0; i < order / 2; ++i)
+    {
+        const auto invQ = getButterworthInverseQuality<DesignMath>(i, order);
+        lowCut[i] = makeNormalisedBiquad(1.0, -2.0, 1.0,
+            1.0 + invQ * n + nSquared, 2.0 * (nSquared - 1.0), 1.0 - invQ * n + nSquared);
+    }
+}
+
+template<typename DesignMath>
+static void designHighCut(CutCoefficients& highCut, const ChainSettings& chainSettings, double sampleRate)
+{
+    jassert(chainSettings.highCutFreq > 0 && chainSettings.highCutFreq <= sampleRate * 0.5);
+
+    const int order = 2 * (chainSettings.highCutSlope + 1);
+    const auto n = 1.0 / DesignMath::tan(juce::MathConstants<double>::pi * chainSettings.highCutFreq / sampleRate);
+    const auto nSquared = n * n;
+
+    for (int i = 0; i < order / 2; ++i)
+    {
+        const auto invQ = getButterworthInverseQuality<DesignMath>(i, order);
+        highCut[i] = makeNormalisedBiquad(1.0, 2.0, 1.0,
+            1.0 + invQ * n + nSquared, 2.0 * (1.0 - nSquared), 1.0 - invQ * n + nSquared);
+    }
+}
+
+void designPeakFilter(BiquadCoefficients& peak, const ChainSettings& chainSettings, double sampleRate)
+{
+    designPeak<PreciseDesignMath>(peak, chainSettings, sampleRate);
+}
+
+void designLowCutFilter(CutCoefficients& lowCut, const ChainSettings& chainSettings, double sampleRate)
+{
+    designLowCut<PreciseDesignMath>(lowCut, chainSettings, sampleRate);
+}
+
+void designHighCutFilter(CutCoefficients& highCut, const ChainSettings& chainSettings, double sampleRate)
+{
+    designHighCut<PreciseDesignMath>(highCut, chainSettings, sampleRate);
+}
+
+// the peak and high cut run oversampled, the low cut always runs at the host rate
+double getOversampledRate(const ChainSettings& chainSettings, double sampleRate)
+{
+    return sampleRate * double(1 << chainSettings.oversampling);
+}
+
+void designChainCoefficients(ChainCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+    const auto oversampledRate = getOversampledRate(chainSettings, sampleRate);
+
+    designPeakFilter(coefficients.peak, chainSettings, oversampledRate);
+    designLowCutFilter(coefficients.lowCut, chainSettings, sampleRate);
+    designHighCutFilter(coefficients.highCut, chainSettings, oversampledRate);
+}
+
+void designChainCoefficientsFast(ChainCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate)
 {
-    *old = *replacements;
+    const auto oversampledRate = getOversampledRate(chainSettings, sampleRate);
+
+    designPeak<FastDesignMath>(coefficients.peak, chainSettings, oversampledRate);
+    designLowCut<FastDesignMath>(coefficients.lowCut, chainSettings, sampleRate);
+    designHighCut<FastDesignMath>(coefficients.highCut, chainSettings, oversampledRate);
+}
+
+//==============================================================================
+//
+// BiquadResponseEvaluator:: members
+// 
+//==============================================================================
+void BiquadResponseEvaluator::prepare(std::span<const double> frequencies, double sampleRate)
+{
+    numFrequencies = int(frequencies.size());
+    tableSampleRate = sampleRate;
+
+    const auto numVecs = size_t((numFrequencies + int(Vec::size()) - 1) / int(Vec::size()));
+
+    for (auto* table : { &cos1, &sin1, &cos2, &sin2, &numeratorPower, &denominatorPower })
+    {
+        table->resize(numVecs);
+    }
+
+    alignas(Vec) double c1[Vec::size()], s1[Vec::size()], c2[Vec::size()], s2[Vec::size()];
+
+    for (size_t v = 0; v < numVecs; ++v)
+    {
+        for (size_t lane = 0; lane < Vec::size(); ++lane)
+        {
+            // the padding lanes repeat the last frequency
+            const auto index = juce::jmin(v * Vec::size() + lane, frequencies.size() - 1);
+            const auto w = juce::MathConstants<double>::twoPi * frequencies[index] / sampleRate;
+
+            c1[lane] = std::cos(w);
+            s1[lane] = std::sin(w);
+            c2[lane] = std::cos(2.0 * w);
+            s2[lane] = std::sin(2.0 * w);
+        }
+
+        cos1[v] = Vec::fromRawArray(c1);
+        sin1[v] = Vec::fromRawArray(s1);
+        cos2[v] = Vec::fromRawArray(c2);
+        sin2[v] = Vec::fromRawArray(s2);
+    }
+}
+
+void BiquadResponseEvaluator::evaluate(std::span<const BiquadCoefficients> sections, std::span<double> magnitudesInDecibels,
+    double minusInfinityDb)
+{
+    jassert(int(magnitudesInDecibels.size()) >= numFrequencies);
+
+    const auto numVecs = cos1.size();
+    const auto one = Vec::expand(1.0);
+
+    std::fill(numeratorPower.begin(), numeratorPower.end(), one);
+    std::fill(denominatorPower.begin(), denominatorPower.end(), one);
+
+    // with z^-1 = cos w - j sin w:
+    //   |b0 + b1 z^-1 + b2 z^-2|^2 = (b0 + b1 cos w + b2 cos 2w)^2 + (b1 sin w + b2 sin 2w)^2
+    // and the same for 1 + a1 z^-1 + a2 z^-2
+    for (const auto& section : sections)
+    {
+        const auto b0 = Vec::expand(section.b0), b1 = Vec::expand(section.b1), b2 = Vec::expand(section.b2);
+        const auto a1 = Vec::expand(section.a1), a2 = Vec::expand(section.a2);
+
+        for (size_t v = 0; v < numVecs; ++v)
+        {
+            const auto numeratorRe = b0 + b1 * cos1[v] + b2 * cos2[v];
+            const auto numeratorIm = b1 * sin1[v] + b2 * sin2[v];
+            const auto denominatorRe = one + a1 * cos1[v] + a2 * cos2[v];
+            const auto denominatorIm = a1 * sin1[v] + a2 * sin2[v];
+
+            numeratorPower[v] = numeratorPower[v] * (numeratorRe * numeratorRe + numeratorIm * numeratorIm);
+            denominatorPower[v] = denominatorPower[v] * (denominatorRe * denominatorRe + denominatorIm * denominatorIm);
+        }
+    }
+
+    alignas(Vec) double numerator[Vec::size()], denominator[Vec::size()];
+
+    for (size_t v = 0; v < numVecs; ++v)
+    {
+        numeratorPower[v].copyToRawArray(numerator);
+        denominatorPower[v].copyToRawArray(denominator);
+
+        for (size_t lane = 0; lane < Vec::size(); ++lane)
+        {
+            const auto index = v * Vec::size() + lane;
+            if (index >= size_t(numFrequencies))
+            {
+                break;
+            }
+
+            // power ratio, so 10 log10
+            const auto power = numerator[lane] / denominator[lane];
+            magnitudesInDecibels[index] = power > 0 ? juce::jmax(10.0 * std::log10(power), minusInfinityDb) : minusInfinityDb;
+        }
+    }
 }
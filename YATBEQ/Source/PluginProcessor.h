@@ -11,9 +11,44 @@
 #include <JuceHeader.h>
 
 #include <array>
+#include <atomic>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 1 logs the cost of a block through the float and the double chain from prepareToPlay().
+// off in normal builds, set it in the exporter's preprocessor definitions
+#ifndef YATBEQ_BENCHMARK_PRECISION
+ #define YATBEQ_BENCHMARK_PRECISION 0
+#endif
+
+// 1 logs the cost of a block through the chain at 1x, 2x, 4x and 8x oversampling, the same way
+#ifndef YATBEQ_BENCHMARK_OVERSAMPLING
+ #define YATBEQ_BENCHMARK_OVERSAMPLING 0
+#endif
+
+// 1 logs the cost of a block of 2 to 64 channels with and without the chain workers, the same way
+#ifndef YATBEQ_BENCHMARK_MULTITHREADING
+ #define YATBEQ_BENCHMARK_MULTITHREADING 0
+#endif
+
+// average wall clock time of run() over numRuns calls, in milliseconds. what the YATBEQ_BENCHMARK_* blocks time with
+template<typename Function>
+double averageMilliseconds(int numRuns, Function&& run)
+{
+    const auto start = juce::Time::getHighResolutionTicks();
+    for (int i = 0; i < numRuns; ++i)
+    {
+        run();
+    }
+
+    return 1000.0 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) / numRuns;
+}
 template<typename T>
 struct Fifo
 {
+    // prepare() also drops anything still queued, so the reader never sees a slot of the old size
     void prepare(int numChannels, int numSamples)
     {
         static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
@@ -24,6 +59,7 @@ struct Fifo
             buffer.setSize(numChannels, numSamples, false, true, true);
             buffer.clear();
 	    }
+        fifo.reset();
     }
 
     void prepare(size_t numElements)
@@ -36,6 +72,7 @@ struct Fifo
             buffer.clear();
             buffer.resize(numElements, 0);
         }
+        fifo.reset();
     }
 
     bool push(const T& t)
@@ -60,6 +97,32 @@ struct Fifo
         return false;
     }
 
+    // in place versions of push() and pull(): the callback gets the slot itself, so only the index is handed over.
+    // the slot is published or released when the callback returns
+    template<typename Callback>
+    bool write(Callback&& fill)
+    {
+        auto write = fifo.write(1);
+        if(write.blockSize1 > 0)
+        {
+            fill(buffers[write.startIndex1]);
+            return true;
+        }
+        return false;
+    }
+
+    template<typename Callback>
+    bool read(Callback&& use)
+    {
+        auto read = fifo.read(1);
+        if(read.blockSize1 > 0)
+        {
+            use(buffers[read.startIndex1]);
+            return true;
+        }
+        return false;
+    }
+
     int getNumAvailableForReading() const
     {
         return fifo.getNumReady();
@@ -71,13 +134,54 @@ struct Fifo
         juce::AbstractFifo fifo{ Capacity };
 };
 
+// wait-free handoff of the most recent T from one producer thread to one consumer thread.
+// the producer fills getWriteBuffer() and publishes it, the consumer calls pull() and reads getReadBuffer().
+// neither side ever blocks, intermediate values the consumer didn't get to are simply dropped
+template<typename T>
+struct TripleBuffer
+{
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+
+    void publish()
+    {
+        auto previous = middle.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    bool pull()
+    {
+        if ((middle.load(std::memory_order_acquire) & newDataFlag) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+
+    std::array<T, 3> buffers;
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle{ 2 };
+};
+
+// the host channel index each analyzer tap reads, so leftChannelFifo follows channel 0
 enum Channel
 {
-	Right,// effectively 0
-    Left  // effectively 1
+    Left = 0,
+    Right = 1
 };
 
-template<typename BlockType>
+// the analyzer tap: a single producer, single consumer ring of raw float samples.
+// the audio thread copies each block in with one or two FloatVectorOperations calls,
+// the editor reads straight out of the ring through spans, nothing is copy-assigned or allocated after prepare().
+// prepare() can run while the analyzer thread is reading, so it waits for a read in progress before it
+// reallocates, and a read that starts during prepare() sees an empty ring
 struct SingleChannelSampleFifo
 {
 	SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
@@ -85,55 +189,198 @@ struct SingleChannelSampleFifo
         prepared.set(false);
 	}
 
-    void update(const BlockType& buffer)
+    // audio thread. takes float or double buffers, the analyzer always works in float.
+    // with a decimationFactor above 1 the tap is low-passed and keeps every decimationFactor'th sample.
+    // when the reader falls behind, the samples that don't fit are dropped
+    template<typename SampleType>
+    void update(const juce::AudioBuffer<SampleType>& buffer, int decimationFactor = 1)
 	{
         jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        jassert(buffer.getNumChannels() > 0);
+
+        // a mono bus feeds both analyzer channels from channel 0
+        auto* channelPtr = buffer.getReadPointer(juce::jmin(int(channelToUse), buffer.getNumChannels() - 1));
+
+        if (decimationFactor != decimation.get())
+        {
+            setDecimation(decimationFactor);
+        }
+
+        if (decimationFactor == 1)
+        {
+            const auto write = fifo.write(buffer.getNumSamples());
+            copyIn(ring.data() + write.startIndex1, channelPtr, write.blockSize1);
+            copyIn(ring.data() + write.startIndex2, channelPtr + write.blockSize1, write.blockSize2);
+            return;
+        }
+
+        // the decimated samples go straight into the ring, so work out how many this block yields first
+        const auto numSamples = buffer.getNumSamples();
+        const auto numDecimated = (decimationPhase + numSamples) / decimationFactor;
+
+        const auto write = fifo.write(numDecimated);
+        float* const destinations[] = { ring.data() + write.startIndex1, ring.data() + write.startIndex2 };
+        const int destinationSizes[] = { write.blockSize1, write.blockSize2 };
+        int destination = 0, written = 0;
 
-        for(int i = 0; i < buffer.getNumSamples(); ++i)
+        for (int i = 0; i < numSamples; ++i)
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            auto sample = static_cast<float>(channelPtr[i]);
+            for (auto& section : decimationFilter)
+            {
+                sample = section.processSample(sample);
+            }
+
+            if (++decimationPhase < decimationFactor)
+            {
+                continue;
+            }
+
+            decimationPhase = 0;
+
+            // past the space the fifo granted, the rest of the block is dropped
+            if (destination < 2 && written == destinationSizes[destination])
+            {
+                destination += (destinationSizes[1] > 0) ? 1 : 2;
+                written = 0;
+            }
+
+            if (destination < 2)
+            {
+                destinations[destination][written++] = sample;
+            }
         }
 	}
 
-    void prepare(int bufferSize)
+    // not on the audio thread
+    void prepare(int bufferSize, double sampleRate)
 	{
         prepared.set(false);
+        while (reading.get())
+        {
+            std::this_thread::yield();
+        }
+
         size.set(bufferSize);
 
-        bufferToFill.setSize(1, bufferSize, false, true, true);
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
-        prepared.set(true);
+        // sized by time rather than by block, a 32 sample block would otherwise leave less than one small FFT.
+        // two of the largest FFTs, and two blocks for hosts with very large ones
+        const auto ringSize = juce::jmax(2 * maxFFTSize, int(sampleRate * minimumSecondsOfHistory), 2 * bufferSize);
+        ring.assign(size_t(ringSize), 0.f);
+        fifo.setTotalSize(ringSize);
+
+        // 4th order Butterworth below the decimated Nyquist, designed once per factor
+        // so switching factors on the audio thread only swaps coefficient pointers
+        for (int factor : { 2, 4 })
+        {
+            auto coefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
+                0.4f * float(sampleRate) / float(factor), sampleRate, 4);
+            jassert(coefficients.size() == int(decimationFilter.size()));
+
+            auto& designed = decimationCoefficients[size_t(factor / 4)];
+            for (size_t i = 0; i < designed.size(); ++i)
+            {
+                designed[i] = coefficients[int(i)];
+            }
+        }
+
+        // sizes the filter state here rather than on the first switch
+        for (size_t i = 0; i < decimationFilter.size(); ++i)
+        {
+            decimationFilter[i].coefficients = decimationCoefficients[0][i];
+            decimationFilter[i].reset();
+        }
+
+        setDecimation(1);
         prepared.set(true);
 	}
     //=========================================================================================
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
+    // editor side. hands the oldest numSamples unread samples to callback(std::span<const float>, std::span<const float>),
+    // the second span is the part that wrapped around and is usually empty. the samples are released when it returns
+    template<typename Callback>
+    void read(int numSamples, Callback&& callback)
+    {
+        const ScopedReading scopedReading(*this);
+        if (!isPrepared())
+        {
+            return;
+        }
+
+        const auto scope = fifo.read(numSamples);
+        callback(std::span<const float>(ring.data() + scope.startIndex1, size_t(scope.blockSize1)),
+                 std::span<const float>(ring.data() + scope.startIndex2, size_t(scope.blockSize2)));
+    }
+
+    int getNumSamplesAvailable() const
+    {
+        const ScopedReading scopedReading(*this);
+        return isPrepared() ? fifo.getNumReady() : 0;
+    }
+
+    // the largest "Analyzer FFT Size", FFTOrder::order8192 in the editor
+    static constexpr int maxFFTSize = 1 << 13;
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
+
+    // the factor the samples in the ring were decimated by, the tap's sample rate is the host rate over this
+    int getDecimation() const { return decimation.get(); }
     //==========================================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
 private:
+    // how much the ring holds at the host rate, a decimated tap holds that many times longer
+    static constexpr double minimumSecondsOfHistory = 0.25;
+
     Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
+    std::vector<float> ring;
+    juce::AbstractFifo fifo{ 1 };
     juce::Atomic<bool> prepared = false;
     juce::Atomic<int> size = 0;
 
-    void pushNextSampleIntoFifo(float sample)
+    // set by the reader around every look at the ring or the fifo, prepare() clears prepared and then waits for
+    // this, both sequentially consistent so either the reader sees the ring unprepared or prepare() sees it reading
+    mutable juce::Atomic<bool> reading = false;
+
+    struct ScopedReading
     {
-	    if(fifoIndex == bufferToFill.getNumSamples())
-	    {
-            auto ok = audioBufferFifo.push(bufferToFill);
+        explicit ScopedReading(const SingleChannelSampleFifo& f) : fifo(f) { fifo.reading.set(true); }
+        ~ScopedReading() { fifo.reading.set(false); }
 
-            juce::ignoreUnused(ok);
-            fifoIndex = 0;
-	    }
+    private:
+        const SingleChannelSampleFifo& fifo;
+    };
+
+    juce::Atomic<int> decimation = 1;
+    int decimationPhase = 0;
+    std::array<juce::dsp::IIR::Filter<float>, 2> decimationFilter;
+
+    // [0] for 2:1, [1] for 4:1
+    std::array<std::array<juce::dsp::IIR::Coefficients<float>::Ptr, 2>, 2> decimationCoefficients;
+
+    void setDecimation(int factor)
+    {
+        decimation.set(factor);
+        decimationPhase = 0;
 
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
+        if (factor > 1)
+        {
+            const auto& designed = decimationCoefficients[size_t(factor / 4)];
+            for (size_t i = 0; i < decimationFilter.size(); ++i)
+            {
+                decimationFilter[i].coefficients = designed[i];
+                decimationFilter[i].reset();
+            }
+        }
+    }
+
+    static void copyIn(float* dest, const float* source, int numSamples)
+    {
+        if (numSamples > 0)
+            juce::FloatVectorOperations::copy(dest, source, numSamples);
+    }
+
+    static void copyIn(float* dest, const double* source, int numSamples)
+    {
+        if (numSamples > 0)
+            juce::FloatVectorOperations::convert(dest, source, numSamples);
     }
 };
 
@@ -142,106 +389,362 @@ enum Cut_Slope
     Slope_12, Slope_24, Slope_36, Slope_48
 };
 
+// the factor is 1 << Oversampling_Factor, the Peak and HighCut sections run at that multiple of the host rate
+enum Oversampling_Factor
+{
+    Oversampling_1x, Oversampling_2x, Oversampling_4x
+};
+
+// which pair of spectra the analyzer draws
+enum Analyzer_Mode
+{
+    Analyzer_LeftRight, Analyzer_MidSide
+};
+
+// how the editor draws the spectra: stroked paths, spans written straight into an image,
+// or a scrolling spectrogram of their history
+enum Analyzer_Renderer
+{
+    Analyzer_PathRenderer, Analyzer_BitmapRenderer, Analyzer_FilledBitmapRenderer, Analyzer_SpectrogramRenderer
+};
+
 struct ChainSettings
 {
     float peakFreq{ 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
     float lowCutFreq{ 0 }, highCutFreq{ 0 };
     Cut_Slope lowCutSlope{ Cut_Slope::Slope_12 }, highCutSlope{ Cut_Slope::Slope_12 };
     bool lowCutBypassed {false}, peakBypassed{ false }, highCutBypassed{ false };
+    Oversampling_Factor oversampling{ Oversampling_1x };
 
+    // exact, both sides come from the same parameter atomics or the same finished ramp
+    bool operator==(const ChainSettings&) const = default;
 };
 
 ChainSettings getTreeStateChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
-using Filter = juce::dsp::IIR::Filter<float>;
+// the raw parameter atomics, looked up once so the audio thread never searches the apvts by name
+struct ChainParameters
+{
+    void attachTo(juce::AudioProcessorValueTreeState& apvts);
+
+    // everything a design depends on, the processor only listens to these
+    static constexpr std::array<const char*, 11> parameterIDs
+    {
+        "LowCut Freq", "HighCut Freq", "Peak Freq", "Peak Gain", "Peak Quality", "LowCut Slope", "HighCut Slope",
+        "LowCut Bypassed", "HighCut Bypassed", "Peak Bypassed", "Oversampling"
+    };
+
+    std::atomic<float>* lowCutFreq{ nullptr };
+    std::atomic<float>* highCutFreq{ nullptr };
+    std::atomic<float>* peakFreq{ nullptr };
+    std::atomic<float>* peakGainInDecibels{ nullptr };
+    std::atomic<float>* peakQuality{ nullptr };
+    std::atomic<float>* lowCutSlope{ nullptr };
+    std::atomic<float>* highCutSlope{ nullptr };
+    std::atomic<float>* lowCutBypassed{ nullptr };
+    std::atomic<float>* highCutBypassed{ nullptr };
+    std::atomic<float>* peakBypassed{ nullptr };
+    std::atomic<float>* oversampling{ nullptr };
+};
 
-// declare an alias to some relatively unknown type
-using MyCoefficients = Filter::CoefficientsPtr;
+ChainSettings getChainSettings(const ChainParameters& chainParameters);
 
-inline 
-MyCoefficients makeThisPeakFilter(const ChainSettings& chainSettings, double sampleRate)
+// normalised second order section, a0 is already divided out.
+// the member order matches juce::dsp::IIR::Coefficients<float>::coefficients for an order 2 filter.
+// designed and kept in double, the float and double chains each round it to their own sample type
+struct BiquadCoefficients
 {
-    MyCoefficients rtn = juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-        sampleRate, chainSettings.peakFreq, chainSettings.peakQuality,
-        juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
-    return rtn;
-}
+    double b0{ 1 }, b1{ 0 }, b2{ 0 }, a1{ 0 }, a2{ 0 };
+};
 
-// use the alias to declare a helper function
-void updateCoefficients(MyCoefficients& old, const MyCoefficients& replacements);
+// every Cut_Slope needs at most 4 sections (Slope_48 is an 8th order Butterworth)
+static constexpr int MaxCutSections = 4;
+using CutCoefficients = std::array<BiquadCoefficients, MaxCutSections>;
 
+// the complete coefficient set for one channel's cascade, sized up front so designing it never allocates
+struct ChainCoefficients
+{
+    BiquadCoefficients peak;
+    CutCoefficients lowCut, highCut;
+};
 
+// allocation free filter designs, safe to call on the audio thread
+void designPeakFilter(BiquadCoefficients& peak, const ChainSettings& chainSettings, double sampleRate);
+void designLowCutFilter(CutCoefficients& lowCut, const ChainSettings& chainSettings, double sampleRate);
+void designHighCutFilter(CutCoefficients& highCut, const ChainSettings& chainSettings, double sampleRate);
+void designChainCoefficients(ChainCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate);
 
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+// same designs using juce::dsp::FastMathApproximations, cheap enough to run every few samples while parameters ramp
+void designChainCoefficientsFast(ChainCoefficients& coefficients, const ChainSettings& chainSettings, double sampleRate);
 
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+// the rate designChainCoefficients() designs the Peak and HighCut sections for
+double getOversampledRate(const ChainSettings& chainSettings, double sampleRate);
 
-enum ChainPositions
+// evaluates the magnitude response of a cascade of BiquadCoefficients at a fixed set of frequencies,
+// SIMDRegister<double>::size() frequencies at a time. cos and sin of w and 2w are tabled in prepare(),
+// so evaluate() is multiply-adds per section and one log10 per frequency.
+// nothing in here depends on the editor, tests and offline tools can run it on designed coefficients directly
+struct BiquadResponseEvaluator
 {
-    LowCut,
-    Peak,
-    HighCut
+    // not on the audio thread, allocates the tables
+    void prepare(std::span<const double> frequencies, double sampleRate);
+
+    int getNumFrequencies() const { return numFrequencies; }
+    double getSampleRate() const { return tableSampleRate; }
+
+    // the combined response of all sections in dB, one value per prepared frequency, floored at minusInfinityDb
+    void evaluate(std::span<const BiquadCoefficients> sections, std::span<double> magnitudesInDecibels,
+        double minusInfinityDb = -100.0);
+
+private:
+    using Vec = juce::dsp::SIMDRegister<double>;
+
+    int numFrequencies = 0;
+    double tableSampleRate = 0;
+
+    // cos w, sin w, cos 2w, sin 2w per frequency, padded to whole registers
+    std::vector<Vec> cos1, sin1, cos2, sin2;
+
+    // |numerator|^2 and |denominator|^2 of the cascade, kept apart so only one division happens per frequency
+    std::vector<Vec> numeratorPower, denominatorPower;
 };
 
-template<int Index, typename ChainType, typename CoefficientType>
-void update(ChainType& chain, CoefficientType& coefficients)
+//==============================================================================
+// one finished filter design, what the CoefficientDesigner hands over to the audio thread
+struct DesignedChain
 {
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
+    ChainSettings chainSettings;
+    ChainCoefficients coefficients;
+    double sampleRate{ 0 };
+};
 
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& cutType, const CoefficientType& cutCoefficients, const Cut_Slope& cutSlope)
+// designs the whole chain on its own thread whenever a parameter changes and publishes
+// the result through a TripleBuffer, so the audio thread only has to pull() the latest set.
+// a change only sets a flag that the designer polls, nothing the audio thread calls takes a lock.
+// after pollsBeforePark empty polls the designer parks on an atomic wait, and only then does a request pay for a wake
+struct CoefficientDesigner : juce::Thread
 {
+    CoefficientDesigner(const ChainParameters& params);
+    ~CoefficientDesigner() override;
 
-    cutType.template setBypassed<0>(true);
-    cutType.template setBypassed<1>(true);
-    cutType.template setBypassed<2>(true);
-    cutType.template setBypassed<3>(true);
+    // not on the audio thread
+    void prepare(double sampleRate);
+
+    // not on the audio thread. a design requested while stopped is done once the thread is started again
+    void start();
+    void stop();
+
+    // any thread, the audio thread included. picked up within pollIntervalMs, a batch of changes is one design
+    void requestDesign();
+
+    // audio thread only
+    bool pullDesign() { return designs.pull(); }
+    const DesignedChain& getDesign() const { return designs.getReadBuffer(); }
+
+    void run() override;
+
+private:
+    const ChainParameters& chainParameters;
+    std::atomic<double> designSampleRate{ 0 };
 
-    switch (cutSlope)
+    // seq_cst on both sides, so either requestDesign() sees the designer parked or the designer sees the request
+    std::atomic<bool> designPending{ false }, parked{ false };
+    std::atomic<int> wakeGeneration{ 0 };
+    void wake();
+
+    static constexpr int pollIntervalMs = 5;
+    static constexpr int pollsBeforePark = 100;
+
+    TripleBuffer<DesignedChain> designs;
+};
+
+//==============================================================================
+// a few real-time threads that help the audio thread through the SIMDChain channel groups of wide buses.
+// the audio thread publishes a job by bumping a generation counter, every participant (the audio thread included)
+// claims slices with a compare-and-swap, and the audio thread spin-waits until every slice is done.
+// nothing on the audio thread locks, allocates or waits on a worker that hasn't picked anything up,
+// a worker that is descheduled or asleep just leaves its slices to the others.
+// a worker that has been idle for a while parks on an atomic wait, the audio thread only pays for a notify
+// when one of them is parked
+struct ChainWorkerPool
+{
+    using Job = void (*)(void* context, int slice);
+    static constexpr int maxWorkers = 7;
+
+    ~ChainWorkerPool();
+
+    // not on the audio thread. zero workers makes run() do everything on the calling thread.
+    // the workers ask for real-time scheduling with the host block as their period, and fall back
+    // to the highest normal priority where the system refuses. stop() waits for a block that is using the pool to be done with it
+    void start(int numWorkers, double blockPeriodMs);
+    void stop();
+
+    // not on the audio thread
+    int getNumWorkers() const { return int(workers.size()); }
+    double getBlockPeriodMs() const { return periodMs; }
+
+    // audio thread: holds the pool for one block, stop() waits until it is released.
+    // run() may only be called while isActive(), which is false before start() and once a stop() has begun
+    struct ScopedUse
     {
-    case Slope_48:
+        explicit ScopedUse(ChainWorkerPool& p) : pool(p) { pool.inUse.store(true); }
+        ~ScopedUse() { pool.inUse.store(false); }
+
+        bool isActive() const { return pool.active.load(); }
+
+    private:
+        ChainWorkerPool& pool;
+    };
+
+    // audio thread, runs job(context, slice) for every slice in [0, numSlices) and returns once all of them are done
+    void run(Job job, void* context, int numSlices);
+
+private:
+    struct Worker : juce::Thread
     {
-        update<3>(cutType, cutCoefficients);
-    }
-    case Slope_36:
+        Worker(ChainWorkerPool& owner);
+        void run() override;
+
+        ChainWorkerPool& pool;
+    };
+
+    // claims and runs slices of the current job until there are none left, returns false if it got none
+    bool runPendingSlices();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    double periodMs{ 0 };
+
+    // [generation:32][numSlices:16][nextSlice:16], a claim only succeeds against the generation it was read in
+    std::atomic<juce::uint64> work{ 0 };
+    std::atomic<int> completedSlices{ 0 };
+
+    // seq_cst with the work store in run(), so either the audio thread sees a worker parking or the worker sees the job
+    std::atomic<bool> active{ false }, inUse{ false };
+    std::atomic<int> wakeGeneration{ 0 }, numParked{ 0 };
+    void wakeParkedWorkers();
+
+    // written before the generation bump, stable until every slice of that generation has completed
+    Job currentJob{ nullptr };
+    void* currentContext{ nullptr };
+};
+
+//==============================================================================
+// the whole LowCut -> Peak -> HighCut cascade for any number of channels.
+// channels are processed SIMDRegister<SampleType>::size() at a time in lockstep, one channel per lane,
+// with every section in transposed direct form II (the same recursion juce::dsp::IIR::Filter uses)
+template<typename SampleType>
+struct SIMDChain
+{
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int lanes = int(Vec::SIMDNumElements);
+
+    // section slots in processing order: MaxCutSections low cut, the peak, MaxCutSections high cut
+    static constexpr int numSections = 2 * MaxCutSections + 1;
+    static constexpr int firstLowCutSection = 0;
+    static constexpr int peakSection = MaxCutSections;
+    static constexpr int firstHighCutSection = MaxCutSections + 1;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // audio thread, copies the design in and rebuilds the list of active sections
+    void setCoefficients(const DesignedChain& design);
+
+    // which sections process() runs, the oversampled path runs the low cut at the host rate
+    // and the peak and high cut on the upsampled block
+    enum class Stages
     {
-        update<2>(cutType, cutCoefficients);
-    }
-    case Slope_24:
+        All, LowCut, PeakAndHighCut
+    };
+
+    void process(juce::dsp::AudioBlock<SampleType>& block, Stages stages = Stages::All);
+
+    // audio thread, clears the state of just those sections
+    void reset(Stages stages);
+
+    // one group of 'lanes' channels, groups share nothing but the coefficients
+    // so different threads can process different groups of the same block
+    int getNumGroups() const { return int(groups.size()); }
+    void processGroup(juce::dsp::AudioBlock<SampleType>& block, Stages stages, int group);
+
+    // process() with the groups spread over the pool
+    void process(juce::dsp::AudioBlock<SampleType>& block, Stages stages, ChainWorkerPool& pool);
+
+    // audio thread: takes over the filter state of the chain of the other precision channel by channel,
+    // so switching "Double Precision" carries on where the other chain left off
+    template<typename OtherSampleType>
+    void copyStateFrom(const SIMDChain<OtherSampleType>& other)
     {
-        update<1>(cutType, cutCoefficients);
+        constexpr auto otherLanes = SIMDChain<OtherSampleType>::lanes;
+        const auto numChannels = juce::jmin(getNumGroups() * lanes, other.getNumGroups() * otherLanes);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& state = groups[size_t(channel / lanes)];
+            const auto& otherState = other.groups[size_t(channel / otherLanes)];
+            const auto lane = size_t(channel % lanes);
+            const auto otherLane = size_t(channel % otherLanes);
+
+            for (size_t section = 0; section < size_t(numSections); ++section)
+            {
+                state.s1[section].set(lane, static_cast<SampleType>(otherState.s1[section].get(otherLane)));
+                state.s2[section].set(lane, static_cast<SampleType>(otherState.s2[section].get(otherLane)));
+            }
+        }
     }
-    case Slope_12:
+
+private:
+    template<typename> friend struct SIMDChain;
+
+    struct Section
     {
-        update<0>(cutType, cutCoefficients);
-    }
-    }
+        Vec b0, b1, b2, a1, a2;
+    };
 
-}
+    // the state for one group of 'lanes' channels, bypassed sections keep theirs like a bypassed ProcessorChain stage.
+    // cache line aligned so neighbouring groups never share a line
+    struct alignas(64) GroupState
+    {
+        std::array<Vec, numSections> s1, s2;
+    };
 
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(
-        chainSettings.lowCutFreq,
-        sampleRate,
-        2 * (chainSettings.lowCutSlope + 1));
-}
+    std::array<Section, numSections> sections;
 
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
-        chainSettings.highCutFreq,
-        sampleRate,
-        2 * (chainSettings.highCutSlope + 1));
-}
+    // the channel pool, sized for the bus layout in prepare()
+    std::vector<GroupState> groups;
+
+    // one interleaved frame per sample. blocks are worked through tileSize frames at a time so the tile
+    // stays in L1 and every active section runs on a sample before the next sample is loaded.
+    // the tile lives on the stack of whichever thread runs processGroup()
+    static constexpr size_t tileSize = 64;
+    using Tile = std::array<Vec, tileSize>;
+
+    // one fully unrolled kernel per combination of active low cut sections, peak on/off and active high cut sections.
+    // setCoefficients() picks the kernel when the slopes or bypasses change, so process() never tests a bypass flag
+    using CascadeKernel = void (SIMDChain::*)(GroupState&, Tile&, size_t) const;
+    std::array<CascadeKernel, 3> cascadeKernels{};
 
+    static CascadeKernel getCascadeKernel(int numLowCutSections, int numPeakSections, int numHighCutSections);
+
+    template<int NumLowCutSections, int NumPeakSections, int NumHighCutSections>
+    void processCascade(GroupState& state, Tile& tile, size_t numSamples) const;
+
+    static forcedinline Vec processSample(const Section& section, Vec& s1, Vec& s2, Vec x) noexcept
+    {
+        const auto y = (section.b0 * x) + s1;
+        s1 = (section.b1 * x) - (section.a1 * y) + s2;
+        s2 = (section.b2 * x) - (section.a2 * y);
+        return y;
+    }
+};
 
 //==============================================================================
 /**
 */
-class YATBEQAudioProcessor  : public juce::AudioProcessor
+class YATBEQAudioProcessor  : public juce::AudioProcessor,
+    juce::AudioProcessorParameter::Listener,
+    juce::AsyncUpdater,
+    juce::Timer
 {
 public:
     //==============================================================================
@@ -257,6 +760,12 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
+    // proportion of the available block time spent in processBlock, for comparing processing modes
+    double getProcessingLoad() const { return loadMeasurer.getLoadAsProportion(); }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -286,24 +795,104 @@ public:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
     juce::AudioProcessorValueTreeState apvts{*this, nullptr, "Parameters", createParameters() };
 
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {};
+
+    // reports the oversampling latency to the host from the message thread
+    void handleAsyncUpdate() override;
+
+    // follows "Multithreading" with the chain workers from the message thread
+    void timerCallback() override;
+
     //==============================================================================
 
-    using BlockType = juce::AudioBuffer<float>;
-    SingleChannelSampleFifo <BlockType> leftChannelFifo{ Channel::Left };
-    SingleChannelSampleFifo <BlockType> rightChannelFifo{ Channel::Right };
+    SingleChannelSampleFifo leftChannelFifo{ Channel::Left };
+    SingleChannelSampleFifo rightChannelFifo{ Channel::Right };
+
+    // anything that reads the fifos registers itself while it is alive.
+    // with no subscribers, or with "Analyzer Enabled" off, the audio thread skips the tap entirely
+    void addAnalyzerSubscriber() { ++analyzerSubscribers; }
+    void removeAnalyzerSubscriber() { --analyzerSubscribers; }
 
 private:
     //==============================================================================
     //==============================================================================
 
-    MonoChain leftChain, rightChain;
+    SIMDChain<float> floatChain;
+    SIMDChain<double> doubleChain;
+
+    // "Double Precision" parameter: runs the double chain even when the host hands us float buffers
+    std::atomic<float>* doublePrecision{ nullptr };
+    juce::AudioBuffer<double> doublePrecisionBuffer;
 
-    void updatePeakFilter(const ChainSettings& chainSettings);
+    // audio thread: which chain the last float block ran through, a switch hands the filter state across
+    bool processingInDouble{ false };
+    void switchPrecision(bool toDouble);
 
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
+    juce::AudioProcessLoadMeasurer loadMeasurer;
 
-    void updateFilters();
+    // indexed by Oversampling_Factor, [Oversampling_1x] stays empty. all of them are built in prepareToPlay()
+    // so switching the factor on the audio thread only resets state
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 3> floatOversamplers;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<double>>, 3> doubleOversamplers;
+
+    // the factor the current coefficients were designed for
+    Oversampling_Factor activeOversampling{ Oversampling_1x };
+    std::atomic<int> oversamplingLatency{ 0 };
+    int getOversamplingLatency(Oversampling_Factor factor) const;
+
+    ChainParameters chainParameters;
+    CoefficientDesigner coefficientDesigner{ chainParameters };
+
+    void updateFilters(const DesignedChain& design);
+
+    //==============================================================================
+    // "Smoothing" parameter: off, or ramp the continuous parameters and redesign every 'stride' samples
+    std::atomic<float>* smoothingStride{ nullptr };
+    static int getSmoothingStrideInSamples(int choiceIndex);
+
+    static constexpr double smoothingRampSeconds = 0.05;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> smoothedPeakFreq, smoothedPeakQuality,
+        smoothedLowCutFreq, smoothedHighCutFreq;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> smoothedPeakGain;
+
+    // preallocated, the audio thread designs into this while the smoothers ramp
+    DesignedChain smoothedDesign;
+
+    void setSmoothingTargets(const ChainSettings& chainSettings, bool smoothingEnabled);
+    bool isSmoothing() const;
+    void updateSmoothedFilters(int numSamples);
+
+    template<typename SampleType>
+    void processFilters(juce::AudioBuffer<SampleType>& buffer);
+
+    // pool is null when the block runs on the audio thread alone
+    void processChains(juce::dsp::AudioBlock<float>& block, ChainWorkerPool* pool);
+    void processChains(juce::dsp::AudioBlock<double>& block, ChainWorkerPool* pool);
+
+    // "Multithreading" parameter: spread the channel groups over chainWorkers. the workers only run while the
+    // parameter is on, the bus has more than one group and playback is prepared, a stereo bus never pays for them.
+    // started and stopped off the audio thread by updateChainWorkers(), numWantedChainWorkers is 0 when unprepared
+    std::atomic<float>* multithreading{ nullptr };
+    ChainWorkerPool chainWorkers;
+    std::atomic<int> numWantedChainWorkers{ 0 };
+    std::atomic<double> chainWorkerPeriodMs{ 0 };
+    juce::CriticalSection chainWorkersLock;
+    void updateChainWorkers();
+    ChainWorkerPool* getActiveWorkerPool(const ChainWorkerPool::ScopedUse& workers);
+
+    // the smoothing sub-blocks and very small host blocks are over before a worker has claimed a slice,
+    // handing them out would only add the wake and the wait for the slices to the audio thread
+    static constexpr size_t minPooledBlockLength = 64;
+
+    std::atomic<int> analyzerSubscribers{ 0 };
+    std::atomic<float>* analyzerEnabled{ nullptr };
+
+    // "Analyzer Decimation" parameter: index 0, 1, 2 is a 1:1, 2:1 or 4:1 tap
+    std::atomic<float>* analyzerDecimation{ nullptr };
+
+    template<typename SampleType>
+    void updateAnalyzerTap(const juce::AudioBuffer<SampleType>& buffer);
 
     juce::dsp::Oscillator<float> osc;
     //==============================================================================